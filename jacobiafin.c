@@ -0,0 +1,516 @@
+// Topologia da maquina (/sys/devices/system/cpu) e fixacao das threads OpenMP em cpus (somente Linux)
+
+#ifdef __linux__
+#define _GNU_SOURCE // sched_getaffinity, sched_setaffinity e pthread_attr_setaffinity_np
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <omp.h>
+
+#include "jacobiafin.h"
+
+const char *nome_politicas_afinidade[] = {"nenhuma", "compacta", "espalhada", "nucleos", "lista"};
+
+// Le a politica em texto: nenhuma, compacta, espalhada, nucleos ou uma lista de cpus (ex.: 0,2,4-7), que
+// vai para cpus_lista. Retorna a politica ou -1 se o texto for invalido
+int parse_affinity(const char *texto, int *cpus_lista, int *num_lista)
+{
+    for (int p = AFINIDADE_NENHUMA; p < AFINIDADE_LISTA; p++)
+    {
+        if (strcmp(texto, nome_politicas_afinidade[p]) == 0)
+        {
+            return p;
+        }
+    }
+
+    *num_lista = 0;
+    const char *c = texto;
+    while (*c != '\0')
+    {
+        char *fim;
+        if (!isdigit((unsigned char)*c))
+        {
+            return -1;
+        }
+        long primeira = strtol(c, &fim, 10);
+        long ultima = primeira;
+        if (*fim == '-')
+        {
+            c = fim + 1;
+            if (!isdigit((unsigned char)*c))
+            {
+                return -1;
+            }
+            ultima = strtol(c, &fim, 10);
+        }
+        if (ultima < primeira || ultima >= MAX_CPUS_AFINIDADE)
+        {
+            return -1;
+        }
+        for (long cpu = primeira; cpu <= ultima && *num_lista < MAX_CPUS_AFINIDADE; cpu++)
+        {
+            cpus_lista[(*num_lista)++] = (int)cpu;
+        }
+        if (*fim == ',')
+        {
+            fim++;
+        }
+        else if (*fim != '\0')
+        {
+            return -1;
+        }
+        c = fim;
+    }
+
+    return *num_lista > 0 ? AFINIDADE_LISTA : -1;
+}
+
+// Le um inteiro de um arquivo de /sys, padrao se o arquivo nao existir
+static int read_int_file(const char *caminho, int padrao)
+{
+    int valor;
+    FILE *arq = fopen(caminho, "r");
+    if (arq == NULL)
+    {
+        return padrao;
+    }
+    if (fscanf(arq, "%d", &valor) != 1)
+    {
+        valor = padrao;
+    }
+    fclose(arq);
+    return valor;
+}
+
+#ifdef __linux__
+// Cpus do processo antes de qualquer fixacao, lidas uma vez: as de MASCARA_ORIGINAL (processo reexecutado
+// por affinity_reexec, cuja thread mestre ja esta vinculada pelo runtime), a uniao dos lugares de um
+// OMP_PLACES do ambiente ou a mascara atual (lida antes de affinity_apply fixar a thread mestre)
+static int original_mask(cpu_set_t *conj)
+{
+    static cpu_set_t mascara;
+    static int lida = 0; // 1: mascara conhecida, -1: indisponivel
+
+    if (lida == 0)
+    {
+        const char *texto = getenv(MASCARA_ORIGINAL);
+        static int lista[MAX_CPUS_AFINIDADE];
+        int num;
+
+        CPU_ZERO(&mascara);
+        lida = 1;
+        if (texto != NULL && parse_affinity(texto, lista, &num) == AFINIDADE_LISTA)
+        {
+            for (int k = 0; k < num; k++)
+            {
+                CPU_SET(lista[k], &mascara);
+            }
+        }
+        else if (omp_get_num_places() > 0)
+        {
+            for (int lugar = 0; lugar < omp_get_num_places(); lugar++)
+            {
+                int n = omp_get_place_num_procs(lugar);
+                if (n > MAX_CPUS_AFINIDADE)
+                {
+                    continue;
+                }
+                omp_get_place_proc_ids(lugar, lista);
+                for (int k = 0; k < n; k++)
+                {
+                    CPU_SET(lista[k], &mascara);
+                }
+            }
+        }
+        else if (sched_getaffinity(0, sizeof(mascara), &mascara) != 0)
+        {
+            lida = -1;
+        }
+    }
+
+    *conj = mascara;
+    return lida == 1;
+}
+
+// Mascara em texto no formato de parse_affinity, com intervalos (ex.: 0-3,8-11)
+static void mask_to_text(const cpu_set_t *conj, char *texto, size_t tamanho)
+{
+    size_t usado = 0;
+    texto[0] = '\0';
+    for (int c = 0; c < MAX_CPUS_AFINIDADE && c < CPU_SETSIZE && usado < tamanho; c++)
+    {
+        if (!CPU_ISSET(c, conj))
+        {
+            continue;
+        }
+        int ultima = c;
+        while (ultima + 1 < MAX_CPUS_AFINIDADE && ultima + 1 < CPU_SETSIZE && CPU_ISSET(ultima + 1, conj))
+        {
+            ultima++;
+        }
+        usado += snprintf(texto + usado, tamanho - usado, ultima > c ? "%s%d-%d" : "%s%d", usado > 0 ? "," : "", c, ultima);
+        c = ultima;
+    }
+}
+#endif
+
+// Cpus que o processo pode usar (mascara de afinidade original) com pacote e nucleo de cada uma
+void read_topology(jacobi_topologia *topo)
+{
+    char caminho[128];
+    topo->num_cpus = 0;
+
+#ifdef __linux__
+    cpu_set_t conj;
+    int mascara = original_mask(&conj);
+    for (int c = 0; c < MAX_CPUS_AFINIDADE && c < CPU_SETSIZE; c++)
+    {
+        if (mascara ? !CPU_ISSET(c, &conj) : c >= omp_get_num_procs())
+        {
+            continue;
+        }
+        int k = topo->num_cpus++;
+        topo->cpu[k] = c;
+        snprintf(caminho, sizeof(caminho), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", c);
+        topo->pacote[k] = read_int_file(caminho, 0);
+        snprintf(caminho, sizeof(caminho), "/sys/devices/system/cpu/cpu%d/topology/core_id", c);
+        topo->nucleo[k] = read_int_file(caminho, c);
+    }
+#else
+    for (int c = 0; c < omp_get_num_procs() && c < MAX_CPUS_AFINIDADE; c++)
+    {
+        topo->cpu[c] = c;
+        topo->pacote[c] = 0;
+        topo->nucleo[c] = c;
+        topo->num_cpus++;
+    }
+#endif
+
+    // Posicao SMT de cada cpu e contagem de pacotes e nucleos (cpus em ordem crescente de numero)
+    topo->num_pacotes = 0;
+    topo->num_nucleos = 0;
+    for (int k = 0; k < topo->num_cpus; k++)
+    {
+        int mesmo_pacote = 0;
+        topo->smt[k] = 0;
+        for (int a = 0; a < k; a++)
+        {
+            if (topo->pacote[a] == topo->pacote[k])
+            {
+                mesmo_pacote = 1;
+                if (topo->nucleo[a] == topo->nucleo[k])
+                {
+                    topo->smt[k]++;
+                }
+            }
+        }
+        topo->num_pacotes += !mesmo_pacote;
+        topo->num_nucleos += topo->smt[k] == 0;
+    }
+}
+
+// Chave de ordenacao de uma cpu: pacote, depois os dois campos na ordem pedida
+static long sort_key(const jacobi_topologia *topo, int k, int smt_primeiro)
+{
+    long menor = smt_primeiro ? topo->nucleo[k] : topo->smt[k];
+    long maior = smt_primeiro ? topo->smt[k] : topo->nucleo[k];
+    return ((long)topo->pacote[k] << 40) | (maior << 20) | menor;
+}
+
+// Ordena os indices das cpus pela chave (ordenacao por insercao: no maximo MAX_CPUS_AFINIDADE cpus)
+static void sort_cpus(const jacobi_topologia *topo, int *ordem, int n, int smt_primeiro)
+{
+    for (int a = 1; a < n; a++)
+    {
+        int k = ordem[a];
+        long chave = sort_key(topo, k, smt_primeiro);
+        int b = a - 1;
+        while (b >= 0 && sort_key(topo, ordem[b], smt_primeiro) > chave)
+        {
+            ordem[b + 1] = ordem[b];
+            b--;
+        }
+        ordem[b + 1] = k;
+    }
+}
+
+// Cpu de cada uma das T threads (cpus[t]) segundo a politica. Com mais threads que cpus elegiveis a
+// distribuicao da volta
+void affinity_plan(const jacobi_topologia *topo, int politica, const int *cpus_lista, int num_lista, int T, int *cpus)
+{
+    int ordem[MAX_CPUS_AFINIDADE];
+    int n = 0;
+
+    if (politica == AFINIDADE_LISTA)
+    {
+        for (int t = 0; t < T; t++)
+        {
+            cpus[t] = cpus_lista[t % num_lista];
+        }
+        return;
+    }
+
+    for (int k = 0; k < topo->num_cpus; k++)
+    {
+        if (politica != AFINIDADE_NUCLEOS || topo->smt[k] == 0)
+        {
+            ordem[n++] = k;
+        }
+    }
+
+    if (politica != AFINIDADE_ESPALHADA)
+    {
+        // compacta: pacote, nucleo, irma SMT; nucleos: pacote, nucleo
+        sort_cpus(topo, ordem, n, 0);
+        for (int t = 0; t < T; t++)
+        {
+            cpus[t] = topo->cpu[ordem[t % n]];
+        }
+        return;
+    }
+
+    // espalhada: o pacote p recebe as threads [p*T/P, (p+1)*T/P) e, dentro dele, um nucleo por thread
+    // antes de usar as irmas SMT
+    sort_cpus(topo, ordem, n, 1);
+    int inicio_pacote[MAX_CPUS_AFINIDADE + 1];
+    int P = 0;
+    for (int a = 0; a < n; a++)
+    {
+        if (a == 0 || topo->pacote[ordem[a]] != topo->pacote[ordem[a - 1]])
+        {
+            inicio_pacote[P++] = a;
+        }
+    }
+    inicio_pacote[P] = n;
+
+    for (int p = 0; p < P; p++)
+    {
+        int primeira = (int)((long)p * T / P);
+        int ultima = (int)((long)(p + 1) * T / P);
+        int cpus_pacote = inicio_pacote[p + 1] - inicio_pacote[p];
+        for (int t = primeira; t < ultima; t++)
+        {
+            cpus[t] = topo->cpu[ordem[inicio_pacote[p] + (t - primeira) % cpus_pacote]];
+        }
+    }
+}
+
+// OMP_PLACES equivalente a politica, escrito em lugares, e o OMP_PROC_BIND a usar com ele. Os lugares nao
+// dependem do numero de threads: compacta, nucleos e lista tem um lugar por cpu na ordem do plano e
+// threads consecutivas em lugares consecutivos (close); espalhada tem um lugar por nucleo (com as irmas
+// SMT) em ordem de pacote, com as threads distribuidas igualmente entre eles (spread)
+const char *affinity_places(const jacobi_topologia *topo, int politica, const int *cpus_lista, int num_lista,
+                            char *lugares, size_t tamanho)
+{
+    size_t usado = 0;
+    lugares[0] = '\0';
+
+    if (politica != AFINIDADE_ESPALHADA)
+    {
+        int cpus[MAX_CPUS_AFINIDADE];
+        int n = politica == AFINIDADE_LISTA ? num_lista : politica == AFINIDADE_NUCLEOS ? topo->num_nucleos : topo->num_cpus;
+        affinity_plan(topo, politica, cpus_lista, num_lista, n, cpus);
+        for (int t = 0; t < n && usado < tamanho; t++)
+        {
+            usado += snprintf(lugares + usado, tamanho - usado, "%s{%d}", t > 0 ? "," : "", cpus[t]);
+        }
+        return "close";
+    }
+
+    int ordem[MAX_CPUS_AFINIDADE];
+    int n = 0;
+    for (int k = 0; k < topo->num_cpus; k++)
+    {
+        if (topo->smt[k] == 0)
+        {
+            ordem[n++] = k;
+        }
+    }
+    sort_cpus(topo, ordem, n, 0);
+    for (int a = 0; a < n && usado < tamanho; a++)
+    {
+        int k = ordem[a];
+        usado += snprintf(lugares + usado, tamanho - usado, "%s{%d", a > 0 ? "," : "", topo->cpu[k]);
+        for (int irma = 0; irma < topo->num_cpus && usado < tamanho; irma++)
+        {
+            if (irma != k && topo->pacote[irma] == topo->pacote[k] && topo->nucleo[irma] == topo->nucleo[k])
+            {
+                usado += snprintf(lugares + usado, tamanho - usado, ",%d", topo->cpu[irma]);
+            }
+        }
+        if (usado < tamanho)
+        {
+            usado += snprintf(lugares + usado, tamanho - usado, "}");
+        }
+    }
+    return "spread";
+}
+
+// Reexecuta o programa (mesmos argumentos) com OMP_PLACES/OMP_PROC_BIND da politica em texto, para que o
+// runtime OpenMP vincule as threads de todas as regioes. Nao faz nada se a politica eh nenhuma, se o
+// processo ja foi reexecutado ou se OMP_PLACES veio do ambiente (que prevalece). Retorna somente se nao
+// reexecutou; affinity_setup entao fixa as threads diretamente. Deve ser chamada antes de qualquer saida
+void affinity_reexec(const char *texto, char **argv)
+{
+    static jacobi_topologia topo;
+    static int cpus_lista[MAX_CPUS_AFINIDADE];
+    int num_lista;
+
+    int politica = parse_affinity(texto, cpus_lista, &num_lista);
+    if (politica <= AFINIDADE_NENHUMA || getenv(MARCA_AFINIDADE) != NULL || getenv("OMP_PLACES") != NULL)
+    {
+        return;
+    }
+
+    char *lugares = (char *)malloc(TAMANHO_LUGARES);
+    if (lugares == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+    read_topology(&topo);
+    const char *vinculo = affinity_places(&topo, politica, cpus_lista, num_lista, lugares, TAMANHO_LUGARES);
+    affinity_reexec_places(lugares, vinculo, texto, argv);
+    free(lugares);
+}
+
+// Reexecuta o programa com OMP_PLACES = lugares (lista ou nome abstrato, ex.: cores) e OMP_PROC_BIND =
+// vinculo. marca (a politica) vai para MARCA_AFINIDADE e a mascara atual para MASCARA_ORIGINAL
+void affinity_reexec_places(const char *lugares, const char *vinculo, const char *marca, char **argv)
+{
+#ifdef __linux__
+    if (getenv(MARCA_AFINIDADE) != NULL || getenv("OMP_PLACES") != NULL)
+    {
+        return;
+    }
+
+    cpu_set_t conj;
+    char mascara[TAMANHO_LUGARES];
+    if (original_mask(&conj))
+    {
+        mask_to_text(&conj, mascara, sizeof(mascara));
+        setenv(MASCARA_ORIGINAL, mascara, 1);
+    }
+    setenv("OMP_PLACES", lugares, 1);
+    setenv("OMP_PROC_BIND", vinculo, 1);
+    setenv(MARCA_AFINIDADE, marca, 1);
+    fflush(stdout);
+    execv("/proc/self/exe", argv);
+
+    // Sem reexecucao: o ambiente volta ao original
+    unsetenv(MASCARA_ORIGINAL);
+    unsetenv("OMP_PLACES");
+    unsetenv("OMP_PROC_BIND");
+    unsetenv(MARCA_AFINIDADE);
+#endif
+}
+
+// Alternativa a OMP_PLACES quando o programa nao pode se reexecutar: fixa a thread t do time de T threads
+// na cpu cpus[t]. Depende de o runtime reaproveitar as mesmas threads, na mesma ordem, nas regioes
+// seguintes (o caso do libgomp com o mesmo numero de threads), o que o OpenMP nao garante. Retorna 0 se
+// alguma thread nao pode ser fixada
+int affinity_apply(const int *cpus, int T)
+{
+    int falhas = 0;
+
+#ifdef __linux__
+#pragma omp parallel num_threads(T) reduction(+ : falhas)
+    {
+        cpu_set_t conj;
+        CPU_ZERO(&conj);
+        CPU_SET(cpus[omp_get_thread_num()], &conj);
+        falhas += sched_setaffinity(0, sizeof(conj), &conj) != 0; // pid 0: a thread chamadora
+    }
+#else
+    falhas = T;
+#endif
+
+    return falhas == 0;
+}
+
+// Aplica a politica em texto ao time de T threads e descreve a distribuicao em log (NULL: nada). Com
+// OMP_PLACES (affinity_reexec) o vinculo ja eh do runtime e somente eh conferido; sem ele, as threads sao
+// fixadas por affinity_apply. A topologia vem da mascara original. Retorna 0 em caso de erro
+int affinity_setup(const char *texto, int T, FILE *log)
+{
+    static jacobi_topologia topo;
+    static int topologia_lida = 0;
+    static int cpus_lista[MAX_CPUS_AFINIDADE];
+    int num_lista;
+
+    int politica = parse_affinity(texto, cpus_lista, &num_lista);
+    if (politica <= AFINIDADE_NENHUMA)
+    {
+        return politica == AFINIDADE_NENHUMA;
+    }
+    if (!topologia_lida)
+    {
+        read_topology(&topo);
+        topologia_lida = 1;
+    }
+
+    int *cpus = (int *)malloc(sizeof(int) * T);
+    if (cpus == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+    int ok = 1;
+    const char *modo = "sched_setaffinity";
+    if (omp_get_num_places() > 0)
+    {
+        // Threads vinculadas pelo runtime: cpu (primeira do lugar) de cada thread
+        modo = getenv(MARCA_AFINIDADE) != NULL ? "OMP_PLACES" : "OMP_PLACES do ambiente, politica ignorada";
+#pragma omp parallel num_threads(T) reduction(& : ok)
+        {
+            int ids[MAX_CPUS_AFINIDADE];
+            int lugar = omp_get_place_num();
+            int t = omp_get_thread_num();
+            cpus[t] = -1;
+            if (lugar >= 0 && omp_get_place_num_procs(lugar) > 0 && omp_get_place_num_procs(lugar) <= MAX_CPUS_AFINIDADE)
+            {
+                omp_get_place_proc_ids(lugar, ids);
+                cpus[t] = ids[0];
+            }
+            ok &= lugar >= 0;
+        }
+    }
+    else
+    {
+        affinity_plan(&topo, politica, cpus_lista, num_lista, T, cpus);
+        ok = affinity_apply(cpus, T);
+    }
+
+    if (log != NULL)
+    {
+        fprintf(log, "Afinidade %s via %s (%d pacote(s), %d nucleo(s), %d cpu(s)):", nome_politicas_afinidade[politica],
+                modo, topo.num_pacotes, topo.num_nucleos, topo.num_cpus);
+        for (int t = 0; t < T; t++)
+        {
+            fprintf(log, " %d", cpus[t]);
+        }
+        fprintf(log, ok ? "\n" : " (falhou)\n");
+    }
+
+    free(cpus);
+    return ok;
+}
+
+// Atributos das threads auxiliares (leitura adiantada, checkpoints, gravacao da saida): a mascara original
+// do processo, em vez da cpu herdada da thread mestre fixada. O chamador destroi os atributos
+void helper_thread_attr(pthread_attr_t *atributos)
+{
+    pthread_attr_init(atributos);
+#ifdef __linux__
+    cpu_set_t conj;
+    if (original_mask(&conj))
+    {
+        pthread_attr_setaffinity_np(atributos, sizeof(conj), &conj);
+    }
+#endif
+}
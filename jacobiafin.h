@@ -0,0 +1,53 @@
+// Afinidade das threads: le a topologia da maquina em /sys (pacote e nucleo fisico de cada cpu logica) e
+// fixa cada thread do time OpenMP em uma cpu segundo uma politica. As threads de um mesmo pacote recebem
+// numeros consecutivos, de modo que a particao estatica das linhas da varredura (thread t fica com o
+// t-esimo trecho contiguo de linhas) deixa as linhas de cada pacote em um unico trecho da matriz.
+//
+// A politica eh traduzida em OMP_PLACES/OMP_PROC_BIND, que o runtime OpenMP so le ao iniciar: o programa
+// se reexecuta uma vez com essas variaveis (affinity_reexec), e o runtime vincula as threads de todas as
+// regioes paralelas, com qualquer numero de threads. A mascara original do processo fica em
+// MASCARA_ORIGINAL para as threads auxiliares (pthreads de leitura e gravacao), que de outro modo
+// herdariam a cpu da thread mestre
+
+#ifndef JACOBIAFIN_H
+#define JACOBIAFIN_H
+
+#include <stdio.h>
+#include <pthread.h>
+
+#define MAX_CPUS_AFINIDADE 1024
+#define MARCA_AFINIDADE "JACOBI_AFINIDADE" // politica aplicada por affinity_reexec (evita reexecutar de novo)
+#define MASCARA_ORIGINAL "JACOBI_MASCARA"  // cpus do processo antes da fixacao, ex.: 0-7
+#define TAMANHO_LUGARES 16384              // texto de OMP_PLACES
+
+// Politicas de afinidade
+#define AFINIDADE_NENHUMA 0   // threads soltas (escolha do sistema operacional)
+#define AFINIDADE_COMPACTA 1  // preenche um pacote antes do proximo, irmas SMT lado a lado
+#define AFINIDADE_ESPALHADA 2 // divide as threads igualmente entre os pacotes, um nucleo por thread antes do SMT
+#define AFINIDADE_NUCLEOS 3   // uma thread por nucleo fisico (ignora as irmas SMT)
+#define AFINIDADE_LISTA 4     // lista explicita de cpus, ex.: 0,2,4-7
+
+// Cpus logicas disponiveis para o processo
+typedef struct
+{
+    int num_cpus;
+    int num_pacotes;
+    int num_nucleos;
+    int cpu[MAX_CPUS_AFINIDADE];    // numero da cpu logica
+    int pacote[MAX_CPUS_AFINIDADE]; // physical_package_id
+    int nucleo[MAX_CPUS_AFINIDADE]; // core_id (unico apenas dentro do pacote)
+    int smt[MAX_CPUS_AFINIDADE];    // posicao da cpu entre as irmas do mesmo nucleo (0: primeira)
+} jacobi_topologia;
+
+int parse_affinity(const char *texto, int *cpus_lista, int *num_lista);
+void read_topology(jacobi_topologia *topo);
+void affinity_plan(const jacobi_topologia *topo, int politica, const int *cpus_lista, int num_lista, int T, int *cpus);
+const char *affinity_places(const jacobi_topologia *topo, int politica, const int *cpus_lista, int num_lista,
+                            char *lugares, size_t tamanho);
+void affinity_reexec(const char *texto, char **argv);
+void affinity_reexec_places(const char *lugares, const char *vinculo, const char *marca, char **argv);
+int affinity_apply(const int *cpus, int T);
+int affinity_setup(const char *texto, int T, FILE *log);
+void helper_thread_attr(pthread_attr_t *atributos);
+
+#endif
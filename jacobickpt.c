@@ -0,0 +1,209 @@
+// Gravacao assincrona do estado das iteracoes e retomada a partir dele
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <omp.h>
+
+#include "jacobickpt.h"
+#include "jacobiafin.h"
+
+// FNV-1a de 64 bits dos bytes de vet_diag e vet_b (o sistema normalizado eh determinado pela matriz, mas
+// a diagonal e B bastam para distinguir sistemas na pratica, em O(N))
+uint64_t system_signature(const jacobi_contexto *ctx)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    const double *vetores[2] = {ctx->vet_diag, ctx->vet_b};
+
+    for (int v = 0; v < 2; v++)
+    {
+        const unsigned char *bytes = (const unsigned char *)vetores[v];
+        for (size_t k = 0; k < sizeof(double) * ctx->N; k++)
+        {
+            h = (h ^ bytes[k]) * 0x100000001b3ULL;
+        }
+    }
+    return h;
+}
+
+// Grava o estado em um temporario, com fsync, e o renomeia: o checkpoint anterior so eh substituido por
+// um completo
+static int write_state(const char *nome_arq, const jacobi_estado *estado, const double *vet_x)
+{
+    char temporario[4096];
+    snprintf(temporario, sizeof(temporario), "%s.%d.tmp", nome_arq, (int)getpid());
+
+    FILE *arq = fopen(temporario, "wb");
+    if (arq == NULL)
+    {
+        return 0;
+    }
+    int ok = fwrite(estado, sizeof(*estado), 1, arq) == 1;
+    ok = ok && fwrite(vet_x, sizeof(double), estado->N, arq) == (size_t)estado->N;
+    ok = ok && fflush(arq) == 0 && fsync(fileno(arq)) == 0;
+    ok = fclose(arq) == 0 && ok;
+    if (!ok || rename(temporario, nome_arq) != 0)
+    {
+        remove(temporario);
+        return 0;
+    }
+    return 1;
+}
+
+// Thread de gravacao: espera uma copia pendente, grava e libera a copia para o proximo checkpoint
+static void *write_checkpoints(void *arg)
+{
+    jacobi_checkpoint *ckpt = (jacobi_checkpoint *)arg;
+
+    pthread_mutex_lock(&ckpt->trava);
+    for (;;)
+    {
+        while (!ckpt->pendente && !ckpt->parar)
+        {
+            pthread_cond_wait(&ckpt->mudou, &ckpt->trava);
+        }
+        if (!ckpt->pendente)
+        {
+            break;
+        }
+        pthread_mutex_unlock(&ckpt->trava);
+
+        // A copia nao muda enquanto pendente: a gravacao eh feita fora da trava
+        int ok = write_state(ckpt->nome_arq, &ckpt->estado, ckpt->copia);
+
+        pthread_mutex_lock(&ckpt->trava);
+        ckpt->gravados += ok;
+        ckpt->falhas += !ok;
+        ckpt->pendente = 0;
+        pthread_cond_broadcast(&ckpt->mudou);
+    }
+    pthread_mutex_unlock(&ckpt->trava);
+    return NULL;
+}
+
+// Prepara checkpoints do sistema de ctx resolvido com opcoes, a cada 'intervalo' segundos, em nome_arq
+void checkpoint_init(jacobi_checkpoint *ckpt, const char *nome_arq, double intervalo, const jacobi_contexto *ctx,
+                     const jacobi_opcoes *opcoes)
+{
+    memset(ckpt, 0, sizeof(*ckpt));
+    ckpt->nome_arq = nome_arq;
+    ckpt->intervalo = intervalo;
+    ckpt->ultimo = omp_get_wtime();
+    ckpt->N = ctx->N;
+
+    memcpy(ckpt->estado.magica, MAGICA_CHECKPOINT, sizeof(ckpt->estado.magica));
+    ckpt->estado.versao = VERSAO_CHECKPOINT;
+    ckpt->estado.criterio = opcoes->criterio;
+    ckpt->estado.tol = opcoes->tol;
+    ckpt->estado.atol = opcoes->atol;
+    ckpt->estado.max_iteracoes = opcoes->max_iteracoes;
+    ckpt->estado.anderson = opcoes->anderson;
+    ckpt->estado.N = ctx->N;
+    ckpt->estado.assinatura = system_signature(ctx);
+
+    ckpt->copia = (double *)alloc_aligned(sizeof(double) * ctx->N);
+    if (ckpt->copia == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+    pthread_mutex_init(&ckpt->trava, NULL);
+    pthread_cond_init(&ckpt->mudou, NULL);
+    pthread_attr_t atributos;
+    helper_thread_attr(&atributos); // mascara original, nao a cpu da thread mestre
+    if (pthread_create(&ckpt->gravador, &atributos, write_checkpoints, ckpt) != 0)
+    {
+        printf("Erro ao criar a thread de checkpoint\n");
+        exit(1);
+    }
+    pthread_attr_destroy(&atributos);
+}
+
+// Chamado por jacobi_solve a cada iteracao. Passado o intervalo, copia o vetor X (O(N)) para a thread de
+// gravacao e segue sem esperar. Se a gravacao anterior ainda nao terminou, tenta de novo na proxima
+// iteracao, de modo que a varredura nunca espera pelo disco
+void checkpoint_tick(jacobi_checkpoint *ckpt, const double *vet_x, int cont, double error)
+{
+    double agora = omp_get_wtime();
+    if (agora - ckpt->ultimo < ckpt->intervalo)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&ckpt->trava);
+    if (!ckpt->pendente)
+    {
+        memcpy(ckpt->copia, vet_x, sizeof(double) * ckpt->N);
+        ckpt->estado.cont = cont;
+        ckpt->estado.error = error;
+        ckpt->pendente = 1;
+        ckpt->ultimo = agora;
+        pthread_cond_broadcast(&ckpt->mudou);
+    }
+    pthread_mutex_unlock(&ckpt->trava);
+}
+
+// Termina a gravacao pendente e encerra a thread de gravacao
+void checkpoint_free(jacobi_checkpoint *ckpt)
+{
+    pthread_mutex_lock(&ckpt->trava);
+    ckpt->parar = 1;
+    pthread_cond_broadcast(&ckpt->mudou);
+    pthread_mutex_unlock(&ckpt->trava);
+    pthread_join(ckpt->gravador, NULL);
+
+    pthread_mutex_destroy(&ckpt->trava);
+    pthread_cond_destroy(&ckpt->mudou);
+    free_aligned(ckpt->copia);
+}
+
+// Retoma do checkpoint nome_arq: confere o sistema de ctx e os parametros de opcoes, usa o vetor X gravado
+// como chute inicial e guarda o erro em ctx->error. Retorna as iteracoes ja feitas
+int checkpoint_load(const char *nome_arq, jacobi_contexto *ctx, const jacobi_opcoes *opcoes)
+{
+    jacobi_estado estado;
+
+    FILE *arq = fopen(nome_arq, "rb");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+    if (fread(&estado, sizeof(estado), 1, arq) != 1 || memcmp(estado.magica, MAGICA_CHECKPOINT, sizeof(estado.magica)) != 0 ||
+        estado.versao != VERSAO_CHECKPOINT)
+    {
+        printf("Arquivo %s: checkpoint invalido ou de outra versao\n", nome_arq);
+        exit(1);
+    }
+    if (estado.N != ctx->N || estado.assinatura != system_signature(ctx))
+    {
+        printf("Arquivo %s: checkpoint de outro sistema\n", nome_arq);
+        exit(1);
+    }
+    // O limite de iteracoes pode mudar (para estender uma resolucao interrompida pelo limite)
+    if (estado.criterio != (uint32_t)opcoes->criterio || estado.tol != opcoes->tol || estado.atol != opcoes->atol ||
+        estado.anderson != opcoes->anderson)
+    {
+        printf("Arquivo %s: checkpoint gravado com outros parametros do solver\n", nome_arq);
+        exit(1);
+    }
+
+    double *vet_x = (double *)alloc_aligned(sizeof(double) * ctx->N);
+    if (vet_x == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+    if (fread(vet_x, sizeof(double), ctx->N, arq) != (size_t)ctx->N)
+    {
+        printf("Arquivo %s: checkpoint truncado\n", nome_arq);
+        exit(1);
+    }
+    fclose(arq);
+
+    jacobi_set_initial_guess(ctx, vet_x);
+    free_aligned(vet_x);
+    ctx->error = estado.error;
+    return (int)estado.cont;
+}
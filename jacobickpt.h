@@ -0,0 +1,57 @@
+// Checkpoint e retomada: jacobi_solve entrega periodicamente o vetor X, a iteracao e o erro a uma thread
+// de gravacao, que escreve o estado em um arquivo compacto sem parar a varredura. A retomada le o arquivo,
+// confere que ele pertence ao mesmo sistema e aos mesmos parametros e continua da iteracao gravada
+
+#ifndef JACOBICKPT_H
+#define JACOBICKPT_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "jacobipar.h"
+
+#define MAGICA_CHECKPOINT "JACOBIC"
+#define VERSAO_CHECKPOINT 1
+#define INTERVALO_CHECKPOINT 60 // segundos entre checkpoints, padrao
+
+// Cabecalho do arquivo de checkpoint, seguido dos N valores (double) do vetor X
+typedef struct
+{
+    char magica[8];        // MAGICA_CHECKPOINT
+    uint32_t versao;       // VERSAO_CHECKPOINT
+    uint32_t criterio;     // parametros do solver que gravou (conferidos na retomada, exceto max_iteracoes)
+    double tol;
+    double atol;
+    int32_t max_iteracoes;
+    int32_t anderson;
+    int64_t N;             // ordem do sistema
+    uint64_t assinatura;   // hash de vet_diag e vet_b: identifica o sistema
+    int64_t cont;          // iteracoes feitas ate o vetor X gravado
+    double error;          // erro da ultima iteracao
+} jacobi_estado;
+
+typedef struct jacobi_checkpoint
+{
+    const char *nome_arq;    // arquivo de checkpoint
+    double intervalo;        // segundos entre checkpoints
+    double ultimo;           // instante (omp_get_wtime) do ultimo checkpoint entregue
+    int N;
+    double *copia;           // vetor X entregue a thread de gravacao
+    jacobi_estado estado;    // cabecalho correspondente a copia
+    int pendente;            // copia aguardando gravacao (novos checkpoints sao descartados ate la)
+    int parar;
+    int gravados;            // checkpoints gravados
+    int falhas;              // gravacoes que falharam
+    pthread_t gravador;
+    pthread_mutex_t trava;
+    pthread_cond_t mudou;
+} jacobi_checkpoint;
+
+uint64_t system_signature(const jacobi_contexto *ctx);
+void checkpoint_init(jacobi_checkpoint *ckpt, const char *nome_arq, double intervalo, const jacobi_contexto *ctx,
+                     const jacobi_opcoes *opcoes);
+void checkpoint_tick(jacobi_checkpoint *ckpt, const double *vet_x, int cont, double error);
+void checkpoint_free(jacobi_checkpoint *ckpt);
+int checkpoint_load(const char *nome_arq, jacobi_contexto *ctx, const jacobi_opcoes *opcoes);
+
+#endif
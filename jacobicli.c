@@ -0,0 +1,202 @@
+// Cliente do modo servidor (jacobipar --servidor=<socket>): envia um vetor B e as tolerancias e grava a
+// solucao recebida
+//
+// Uso: jacobicli <socket> [--b=<arquivo>] [--criterio=<c1+c2>] [--tol=<tol>] [--atol=<atol>] [--max-iter=<k>] [--reiniciar]
+//                [--saida=<arquivo>] [--info] [--encerrar]
+// O arquivo de B tem N valores em texto; sem --b, o servidor resolve com o B atual. Sem --saida, a
+// solucao vai para a saida padrao
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "jacobiserv.h"
+
+static void init_request(jacobi_pedido *pedido, int operacao)
+{
+    memset(pedido, 0, sizeof(*pedido));
+    memcpy(pedido->magica, MAGICA_PEDIDO, sizeof(pedido->magica));
+    pedido->versao = VERSAO_PROTOCOLO;
+    pedido->operacao = operacao;
+}
+
+// Envia o pedido (e os valores que o seguem) e le o cabecalho da resposta
+static void exchange(int fd, const jacobi_pedido *pedido, const double *valores, size_t n, jacobi_resposta *resposta)
+{
+    if (!send_all(fd, pedido, sizeof(*pedido)) || (n > 0 && !send_all(fd, valores, sizeof(double) * n)) ||
+        !receive_all(fd, resposta, sizeof(*resposta)) ||
+        memcmp(resposta->magica, MAGICA_RESPOSTA, sizeof(resposta->magica)) != 0)
+    {
+        printf("Erro na comunicacao com o servidor\n");
+        exit(1);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    char *arquivo_b = NULL;
+    char *arquivo_saida = NULL;
+    int info = 0;
+    int encerrar = 0;
+    jacobi_pedido pedido;
+
+    if (argc < 2)
+    {
+        printf("Wrong arguments. Please use jacobicli <socket> [--b=<arquivo>] [--criterio=<c1+c2>] [--tol=<tol>] [--atol=<atol>] [--max-iter=<k>] [--reiniciar] [--saida=<arquivo>] [--info] [--encerrar]\n");
+        exit(0);
+    }
+
+    init_request(&pedido, PEDIDO_RESOLVER);
+    for (int i = 2; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--b=", 4) == 0)
+        {
+            arquivo_b = argv[i] + 4;
+        }
+        else if (strncmp(argv[i], "--criterio=", 11) == 0)
+        {
+            int criterio = criteria_from_text(argv[i] + 11);
+            if (criterio < 0)
+            {
+                printf("Criterio de parada desconhecido: %s\n", argv[i] + 11);
+                exit(0);
+            }
+            pedido.criterio = criterio;
+        }
+        else if (strncmp(argv[i], "--tol=", 6) == 0)
+        {
+            pedido.tol = atof(argv[i] + 6);
+        }
+        else if (strncmp(argv[i], "--atol=", 7) == 0)
+        {
+            pedido.atol = atof(argv[i] + 7);
+        }
+        else if (strncmp(argv[i], "--max-iter=", 11) == 0)
+        {
+            pedido.max_iteracoes = atoi(argv[i] + 11);
+        }
+        else if (strcmp(argv[i], "--reiniciar") == 0)
+        {
+            pedido.flags |= PEDIDO_REINICIAR;
+        }
+        else if (strncmp(argv[i], "--saida=", 8) == 0)
+        {
+            arquivo_saida = argv[i] + 8;
+        }
+        else if (strcmp(argv[i], "--info") == 0)
+        {
+            info = 1;
+        }
+        else if (strcmp(argv[i], "--encerrar") == 0)
+        {
+            encerrar = 1;
+        }
+        else
+        {
+            printf("Opcao desconhecida: %s\n", argv[i]);
+            exit(0);
+        }
+    }
+
+    struct sockaddr_un endereco;
+    if (strlen(argv[1]) >= sizeof(endereco.sun_path))
+    {
+        printf("Caminho do socket muito longo: %s\n", argv[1]);
+        exit(1);
+    }
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    strcpy(endereco.sun_path, argv[1]);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&endereco, sizeof(endereco)) != 0)
+    {
+        printf("Erro ao conectar ao servidor em %s\n", argv[1]);
+        exit(1);
+    }
+
+    jacobi_resposta resposta;
+    if (encerrar)
+    {
+        init_request(&pedido, PEDIDO_ENCERRAR);
+        exchange(fd, &pedido, NULL, 0, &resposta);
+        close(fd);
+        return 0;
+    }
+
+    // A ordem do sistema vem do servidor
+    jacobi_pedido consulta;
+    init_request(&consulta, PEDIDO_INFO);
+    exchange(fd, &consulta, NULL, 0, &resposta);
+    int N = (int)resposta.N;
+    if (info)
+    {
+        printf("Ordem do sistema: %d\n", N);
+        close(fd);
+        return 0;
+    }
+
+    double *valores = (double *)malloc(sizeof(double) * N);
+    if (valores == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+
+    pedido.N = N;
+    if (arquivo_b != NULL)
+    {
+        FILE *arq = fopen(arquivo_b, "r");
+        if (arq == NULL)
+        {
+            printf("Erro ao abrir o arquivo %s\n", arquivo_b);
+            exit(1);
+        }
+        for (int i = 0; i < N; i++)
+        {
+            if (fscanf(arq, "%lf", &valores[i]) != 1)
+            {
+                printf("Arquivo %s com menos de %d valores\n", arquivo_b, N);
+                exit(1);
+            }
+        }
+        fclose(arq);
+        pedido.flags |= PEDIDO_COM_B;
+    }
+
+    exchange(fd, &pedido, valores, arquivo_b != NULL ? N : 0, &resposta);
+    if (resposta.status == RESPOSTA_INVALIDA)
+    {
+        printf("Pedido rejeitado pelo servidor\n");
+        exit(1);
+    }
+    if (!receive_all(fd, valores, sizeof(double) * N))
+    {
+        printf("Erro na comunicacao com o servidor\n");
+        exit(1);
+    }
+    close(fd);
+
+    fprintf(stderr, "Status %d: %d iteracoes em %.3f ms, erro %g, residuo %g\n", resposta.status, resposta.cont,
+            1e3 * resposta.tempo, resposta.error, resposta.residuo_inf);
+
+    FILE *saida = arquivo_saida != NULL ? fopen(arquivo_saida, "w") : stdout;
+    if (saida == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", arquivo_saida);
+        exit(1);
+    }
+    for (int i = 0; i < N; i++)
+    {
+        fprintf(saida, "%.17g\n", valores[i]);
+    }
+    if (saida != stdout)
+    {
+        fclose(saida);
+    }
+    free(valores);
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Compressao da matriz normalizada em blocos com expoente compartilhado e varredura sobre ela
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#include "jacobicomp.h"
+
+// Comprime a matriz normalizada de ctx. A escala de cada bloco eh 2^(e - BITS_MANTISSA), com 2^e o menor
+// expoente que cobre o maior valor do bloco, de modo que as mantissas cabem em int16 e a multiplicacao
+// pela escala eh exata. A escala fica em double: em float, blocos com valores abaixo de ~2^-134 ou acima
+// de FLT_MAX perderiam a escala. erro_max compara cada valor com o reconstruido pela varredura
+void compress_matrix(jacobi_comprimida *comp, const jacobi_contexto *ctx)
+{
+    int N = ctx->N;
+    double erro_max = 0;
+
+    comp->N = N;
+    comp->blocos = (N + BLOCO_COMPRIMIDO - 1) / BLOCO_COMPRIMIDO;
+    comp->ld = comp->blocos * BLOCO_COMPRIMIDO;
+    comp->bytes = sizeof(int16_t) * N * comp->ld + sizeof(double) * N * comp->blocos;
+    comp->mantissas = (int16_t *)alloc_aligned(sizeof(int16_t) * N * comp->ld);
+    comp->escalas = (double *)alloc_aligned(sizeof(double) * N * comp->blocos);
+    if (comp->mantissas == NULL || comp->escalas == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+
+#pragma omp parallel for num_threads(ctx->T) schedule(static) reduction(max : erro_max)
+    for (int i = 0; i < N; i++)
+    {
+        const double *linha = ctx->matrix + (size_t)i * ctx->ld;
+        int16_t *q = comp->mantissas + (size_t)i * comp->ld;
+
+        for (int b = 0; b < comp->blocos; b++)
+        {
+            int j0 = b * BLOCO_COMPRIMIDO;
+            int j1 = j0 + BLOCO_COMPRIMIDO < N ? j0 + BLOCO_COMPRIMIDO : N;
+            double maior = 0;
+            for (int j = j0; j < j1; j++)
+            {
+                maior = fmax(maior, fabs(linha[j]));
+            }
+
+            int e = 0;
+            if (maior > 0)
+            {
+                frexp(maior, &e); // maior < 2^e
+            }
+            double escala = ldexp(1, e - BITS_MANTISSA); // 0 se o bloco so tem valores subnormais minimos
+            comp->escalas[(size_t)i * comp->blocos + b] = escala;
+
+            for (int j = j0; j < j1; j++)
+            {
+                double m = escala > 0 ? nearbyint(linha[j] / escala) : 0;
+                m = fmin(fmax(m, -INT16_MAX), INT16_MAX);
+                q[j] = (int16_t)m;
+                erro_max = fmax(erro_max, fabs(linha[j] - q[j] * comp->escalas[(size_t)i * comp->blocos + b]));
+            }
+        }
+        memset(q + N, 0, sizeof(int16_t) * (comp->ld - N));
+    }
+    comp->erro_max = erro_max;
+}
+
+void compressed_free(jacobi_comprimida *comp)
+{
+    free_aligned(comp->mantissas);
+    free_aligned(comp->escalas);
+}
+
+// Uma varredura sobre a matriz comprimida: vet_soma[i] = B*[i] - A*[i j].x[j]
+void compressed_sweep(const jacobi_comprimida *comp, const double *vet_b, const double *vet_x, double *vet_soma, int T)
+{
+    int N = comp->N;
+
+#pragma omp parallel for num_threads(T) schedule(static)
+    for (int i = 0; i < N; i++)
+    {
+        const int16_t *q = comp->mantissas + (size_t)i * comp->ld;
+        const double *escalas = comp->escalas + (size_t)i * comp->blocos;
+        double soma = vet_b[i];
+
+        for (int b = 0; b < comp->blocos; b++)
+        {
+            int j0 = b * BLOCO_COMPRIMIDO;
+            int j1 = j0 + BLOCO_COMPRIMIDO < N ? j0 + BLOCO_COMPRIMIDO : N;
+            double acc = 0;
+#pragma omp simd reduction(+ : acc)
+            for (int j = j0; j < j1; j++)
+            {
+                acc += q[j] * vet_x[j];
+            }
+            soma -= escalas[b] * acc;
+        }
+        vet_soma[i] = soma;
+    }
+}
+
+// Equivalente de calculate_new_x sobre a matriz comprimida
+void compressed_new_x(const jacobi_comprimida *comp, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x,
+                      double *residuo, int N, int T)
+{
+    double res_max = 0;
+    double res_quad = 0;
+
+#pragma omp parallel for simd num_threads(T)
+    for (int i = 0; i < N; i++)
+    {
+        vet_x[i] = vet_new_x[i]; // vetor X recebe o novo vetor X (proximo chute)
+    }
+
+    compressed_sweep(comp, vet_b, vet_x, vet_new_x, T);
+
+    // Residuo do sistema (com a matriz comprimida) no vetor X atual, como em calculate_new_x
+#pragma omp parallel for simd num_threads(T) reduction(max : res_max) reduction(+ : res_quad)
+    for (int i = 0; i < N; i++)
+    {
+        double r = vet_diag[i] * (vet_new_x[i] - vet_x[i]);
+        res_max = fmax(res_max, fabs(r));
+        res_quad += r * r;
+    }
+    residuo[0] = res_max;
+    residuo[1] = res_quad;
+}
+
+void compressed_report(const jacobi_comprimida *comp, FILE *arq)
+{
+    double densa = sizeof(double) * (double)comp->N * comp->N;
+    fprintf(arq, "Matriz comprimida: %.1f MiB (%.1f%% da densa), erro maximo %g por elemento normalizado\n",
+            comp->bytes / 1048576.0, 100 * comp->bytes / densa, comp->erro_max);
+}
@@ -0,0 +1,36 @@
+// Matriz comprimida com erro limitado: cada linha eh dividida em blocos de BLOCO_COMPRIMIDO colunas que
+// compartilham um expoente (escala potencia de 2) e guardam mantissas de 16 bits. A varredura le 2 bytes
+// por elemento em vez de 8 e reconstroi os valores nos registradores: a soma do bloco eh feita com as
+// mantissas e multiplicada uma vez pela escala. Erro por elemento <= 2^-15 do maior valor do bloco
+
+#ifndef JACOBICOMP_H
+#define JACOBICOMP_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "jacobipar.h"
+
+#define BLOCO_COMPRIMIDO 64 // colunas por bloco com expoente compartilhado
+#define BITS_MANTISSA 15    // bits de magnitude das mantissas (int16 com sinal)
+
+typedef struct jacobi_comprimida
+{
+    int N;
+    int ld;                // distancia (em mantissas) entre linhas, multiplo de BLOCO_COMPRIMIDO
+    int blocos;            // blocos por linha
+    int16_t *mantissas;    // N linhas de ld mantissas
+    double *escalas;       // N linhas de 'blocos' escalas (potencias de 2 exatas em toda a faixa de double)
+    size_t bytes;          // memoria das mantissas e escalas
+    double erro_max;       // maior erro absoluto introduzido na matriz normalizada
+} jacobi_comprimida;
+
+void compress_matrix(jacobi_comprimida *comp, const jacobi_contexto *ctx);
+void compressed_free(jacobi_comprimida *comp);
+void compressed_sweep(const jacobi_comprimida *comp, const double *vet_b, const double *vet_x, double *vet_soma, int T);
+void compressed_new_x(const jacobi_comprimida *comp, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x,
+                      double *residuo, int N, int T);
+void compressed_report(const jacobi_comprimida *comp, FILE *arq);
+
+#endif
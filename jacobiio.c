@@ -0,0 +1,1050 @@
+// Carregamento do sistema a partir de arquivo. O texto Matrix Market eh mapeado em memoria e dividido em
+// T trechos, um por thread, ajustados para comecar no inicio de uma linha; cada thread converte as suas
+// linhas e escreve os elementos direto na matriz (densa, com distancia ld entre linhas)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <limits.h>
+#include <omp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "jacobiio.h"
+#include "jacobiperf.h"
+#include "jacobiafin.h"
+
+#define MAX_TOKEN 64 // caracteres de um numero no texto
+
+// Cabecalho Matrix Market: %%MatrixMarket matrix <coordinate|array> <real|integer|pattern> <general|symmetric>
+typedef struct
+{
+    int coordenadas; // formato coordinate (senao array)
+    int padrao;      // campo pattern: elementos sem valor, iguais a 1
+    int simetrica;   // somente o triangulo inferior esta no arquivo
+    long M, N, nnz;  // dimensoes e elementos armazenados (array: M*N ou o triangulo inferior)
+} cabecalho_mm;
+
+static void file_error(const char *nome_arq, const char *mensagem)
+{
+    printf("Arquivo %s: %s\n", nome_arq, mensagem);
+    exit(1);
+}
+
+// Le o cabecalho e a linha de dimensoes; retorna o deslocamento do primeiro elemento
+static long read_mm_header(FILE *arq, const char *nome_arq, cabecalho_mm *mm)
+{
+    char linha[1024];
+    char objeto[32], formato[32], campo[32], simetria[32];
+
+    if (fgets(linha, sizeof(linha), arq) == NULL ||
+        sscanf(linha, "%%%%MatrixMarket %31s %31s %31s %31s", objeto, formato, campo, simetria) != 4 ||
+        strcasecmp(objeto, "matrix") != 0)
+    {
+        file_error(nome_arq, "cabecalho Matrix Market invalido");
+    }
+
+    mm->coordenadas = strcasecmp(formato, "coordinate") == 0;
+    if (!mm->coordenadas && strcasecmp(formato, "array") != 0)
+    {
+        file_error(nome_arq, "formato deve ser coordinate ou array");
+    }
+    mm->padrao = strcasecmp(campo, "pattern") == 0;
+    if (!mm->padrao && strcasecmp(campo, "real") != 0 && strcasecmp(campo, "integer") != 0 &&
+        strcasecmp(campo, "double") != 0)
+    {
+        file_error(nome_arq, "campo deve ser real, integer ou pattern");
+    }
+    mm->simetrica = strcasecmp(simetria, "symmetric") == 0;
+    if (!mm->simetrica && strcasecmp(simetria, "general") != 0)
+    {
+        file_error(nome_arq, "simetria deve ser general ou symmetric");
+    }
+    if (mm->padrao && !mm->coordenadas)
+    {
+        file_error(nome_arq, "campo pattern exige o formato coordinate");
+    }
+
+    // Comentarios e linhas em branco ate a linha de dimensoes
+    do
+    {
+        if (fgets(linha, sizeof(linha), arq) == NULL)
+        {
+            file_error(nome_arq, "linha de dimensoes ausente");
+        }
+    } while (linha[0] == '%' || strspn(linha, " \t\r\n") == strlen(linha));
+
+    int lidos = mm->coordenadas ? sscanf(linha, "%ld %ld %ld", &mm->M, &mm->N, &mm->nnz)
+                                : sscanf(linha, "%ld %ld", &mm->M, &mm->N);
+    if (lidos != (mm->coordenadas ? 3 : 2) || mm->M <= 0 || mm->N <= 0 || mm->nnz < 0)
+    {
+        file_error(nome_arq, "linha de dimensoes invalida");
+    }
+    if (mm->M != mm->N)
+    {
+        file_error(nome_arq, "a matriz deve ser quadrada");
+    }
+    if (mm->N > INT_MAX)
+    {
+        file_error(nome_arq, "ordem acima do limite");
+    }
+    if (!mm->coordenadas)
+    {
+        mm->nnz = mm->simetrica ? mm->N * (mm->N + 1) / 2 : mm->N * mm->N;
+    }
+
+    return ftell(arq);
+}
+
+// Le o cabecalho do formato binario. Retorna 0 se o arquivo nao comeca com MAGICA_BINARIO
+static int read_binary_header(FILE *arq, const char *nome_arq, jacobi_cabecalho *cab)
+{
+    if (fread(cab, sizeof(*cab), 1, arq) != 1 || memcmp(cab->magica, MAGICA_BINARIO, sizeof(cab->magica)) != 0)
+    {
+        return 0;
+    }
+    if (cab->versao != VERSAO_BINARIO)
+    {
+        file_error(nome_arq, "versao do formato binario nao suportada");
+    }
+    if ((cab->precisao != 4 && cab->precisao != 8) || (cab->layout != LAYOUT_DENSO && cab->layout != LAYOUT_COORDENADAS) ||
+        cab->N <= 0 || cab->N > INT_MAX || cab->nnz < 0)
+    {
+        file_error(nome_arq, "cabecalho binario invalido");
+    }
+    return 1;
+}
+
+// Le o cabecalho da imagem normalizada. Retorna 0 se o arquivo nao comeca com MAGICA_NORMALIZADA
+static int read_image_header(FILE *arq, const char *nome_arq, jacobi_imagem *img)
+{
+    if (fread(img, sizeof(*img), 1, arq) != 1 || memcmp(img->magica, MAGICA_NORMALIZADA, sizeof(img->magica)) != 0)
+    {
+        return 0;
+    }
+    if (img->versao != VERSAO_NORMALIZADA || img->bytes_double != sizeof(double))
+    {
+        file_error(nome_arq, "versao ou representacao da imagem normalizada nao suportada");
+    }
+    if (img->N <= 0 || img->N > INT_MAX || img->ld < img->N || img->ld > INT_MAX ||
+        img->bytes_matriz != (uint64_t)img->N * img->ld * sizeof(double) || img->deslocamento_matriz % ALINHAMENTO_SECAO != 0)
+    {
+        file_error(nome_arq, "cabecalho da imagem normalizada invalido");
+    }
+    return 1;
+}
+
+// Ordem da matriz do arquivo e formato (FORMATO_*): Matrix Market, binario nativo ou imagem normalizada
+int read_matrix_order(const char *nome_arq, int *formato)
+{
+    jacobi_cabecalho cab;
+    jacobi_imagem img;
+    cabecalho_mm mm;
+
+    FILE *arq = fopen(nome_arq, "rb");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+    int N;
+    if (read_binary_header(arq, nome_arq, &cab))
+    {
+        *formato = FORMATO_BINARIO;
+        N = (int)cab.N;
+    }
+    else
+    {
+        rewind(arq);
+        if (read_image_header(arq, nome_arq, &img))
+        {
+            *formato = FORMATO_NORMALIZADO;
+            N = (int)img.N;
+        }
+        else
+        {
+            rewind(arq);
+            read_mm_header(arq, nome_arq, &mm);
+            *formato = FORMATO_MATRIX_MARKET;
+            N = (int)mm.N;
+        }
+    }
+    fclose(arq);
+    return N;
+}
+
+// Copia para token o proximo numero da linha a partir de *p, sem passar de fim (o arquivo mapeado nao
+// termina em '\0'). Retorna 0 no fim da linha
+static int next_token(const char **p, const char *fim, char *token)
+{
+    const char *c = *p;
+    int k = 0;
+    while (c < fim && (*c == ' ' || *c == '\t' || *c == '\r'))
+    {
+        c++;
+    }
+    while (c < fim && !isspace((unsigned char)*c) && k < MAX_TOKEN - 1)
+    {
+        token[k++] = *c++;
+    }
+    token[k] = '\0';
+    *p = c;
+    return k > 0;
+}
+
+// Primeira linha que comeca em pos ou depois dela
+static const char *line_start(const char *inicio, const char *fim, const char *pos)
+{
+    if (pos <= inicio)
+    {
+        return inicio;
+    }
+    while (pos < fim && pos[-1] != '\n')
+    {
+        pos++;
+    }
+    return pos;
+}
+
+// Avanca *p para o inicio da proxima linha
+static void skip_line(const char **p, const char *fim)
+{
+    const char *c = *p;
+    while (c < fim && *c != '\n')
+    {
+        c++;
+    }
+    *p = c < fim ? c + 1 : fim;
+}
+
+// Posicao (i, j) do k-esimo valor do formato array (por colunas; simetrica: triangulo inferior)
+static void array_position(long k, long N, int simetrica, long *i, long *j)
+{
+    if (!simetrica)
+    {
+        *i = k % N;
+        *j = k / N;
+        return;
+    }
+    long col = 0;
+    while (k >= N - col)
+    {
+        k -= N - col;
+        col++;
+    }
+    *i = col + k;
+    *j = col;
+}
+
+// Converte o texto Matrix Market (a partir de inicio_dados) para a matriz de ctx, com as T threads
+static void parse_mm(jacobi_contexto *ctx, const char *nome_arq, const cabecalho_mm *mm, const char *dados, size_t tamanho,
+                     long inicio_dados)
+{
+    int T = ctx->T;
+    int ld = ctx->ld;
+    long N = mm->N;
+    double *matrix = ctx->matrix;
+    const char *inicio = dados + inicio_dados;
+    const char *fim = dados + tamanho;
+    long lidos = 0;
+    long invalidos = 0;
+
+    long *antes = (long *)calloc(T + 1, sizeof(long)); // array: valores nos trechos anteriores ao de cada thread
+    if (antes == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+
+#pragma omp parallel num_threads(T) reduction(+ : lidos, invalidos)
+    {
+        int t = omp_get_thread_num();
+        int nt = omp_get_num_threads();
+        const char *ini = line_start(inicio, fim, inicio + (fim - inicio) * t / nt);
+        const char *fim_bloco = t == nt - 1 ? fim : line_start(inicio, fim, inicio + (fim - inicio) * (t + 1) / nt);
+        char token[MAX_TOKEN];
+        const char *p;
+
+        // Zera as linhas da thread (particao estatica, como na varredura)
+#pragma omp for schedule(static)
+        for (long i = 0; i < N; i++)
+        {
+            memset(matrix + (size_t)i * ld, 0, sizeof(double) * ld);
+        }
+
+        // Formato array: a posicao de cada valor depende de quantos valores vem antes no arquivo
+        long k = 0;
+        if (!mm->coordenadas)
+        {
+            long valores = 0;
+            p = ini;
+            while (p < fim_bloco)
+            {
+                const char *linha = p;
+                if (*linha != '%' && next_token(&p, fim, token))
+                {
+                    valores++;
+                }
+                skip_line(&p, fim);
+            }
+            antes[t + 1] = valores;
+#pragma omp barrier
+#pragma omp single
+            for (int u = 1; u <= nt; u++)
+            {
+                antes[u] += antes[u - 1];
+            }
+            k = antes[t];
+        }
+
+        // Conversao das linhas do trecho
+        p = ini;
+        long i = 0, j = 0;
+        if (!mm->coordenadas)
+        {
+            array_position(k < mm->nnz ? k : 0, N, mm->simetrica, &i, &j);
+        }
+        while (p < fim_bloco)
+        {
+            if (*p == '%')
+            {
+                skip_line(&p, fim);
+                continue;
+            }
+            if (!next_token(&p, fim, token))
+            {
+                skip_line(&p, fim); // linha em branco
+                continue;
+            }
+
+            double v;
+            if (mm->coordenadas)
+            {
+                i = strtol(token, NULL, 10) - 1;
+                j = next_token(&p, fim, token) ? strtol(token, NULL, 10) - 1 : -1;
+                v = mm->padrao ? 1 : (next_token(&p, fim, token) ? strtod(token, NULL) : NAN);
+            }
+            else
+            {
+                v = strtod(token, NULL);
+                if (k >= mm->nnz)
+                {
+                    i = -1;
+                }
+            }
+
+            if (i < 0 || i >= N || j < 0 || j >= N || isnan(v) || (mm->simetrica && j > i))
+            {
+                invalidos++;
+            }
+            else
+            {
+                // Elementos repetidos no arquivo: prevalece um deles
+                matrix[(size_t)i * ld + j] = v;
+                if (mm->simetrica)
+                {
+                    matrix[(size_t)j * ld + i] = v;
+                }
+            }
+            lidos++;
+            skip_line(&p, fim);
+
+            if (!mm->coordenadas && ++k < mm->nnz)
+            {
+                // proxima posicao por colunas
+                if (++i == N)
+                {
+                    j++;
+                    i = mm->simetrica ? j : 0;
+                }
+            }
+        }
+    }
+
+    free(antes);
+    if (invalidos > 0)
+    {
+        printf("Arquivo %s: %ld elementos invalidos ou fora da matriz\n", nome_arq, invalidos);
+        exit(1);
+    }
+    if (lidos != mm->nnz)
+    {
+        printf("Arquivo %s: %ld elementos lidos, %ld esperados\n", nome_arq, lidos, mm->nnz);
+        exit(1);
+    }
+}
+
+// Le exatamente 'bytes' bytes do descritor fd a partir de deslocamento. pread pode ler menos que o pedido
+// (leituras acima de ~2 GiB, sistemas de arquivos de rede ou FUSE): repete ate completar
+static void read_exact(int fd, const char *nome_arq, void *destino, size_t bytes, off_t deslocamento)
+{
+    char *buffer = (char *)destino;
+    size_t lidos = 0;
+    while (lidos < bytes)
+    {
+        ssize_t n = pread(fd, buffer + lidos, bytes - lidos, deslocamento + lidos);
+        if (n <= 0)
+        {
+            file_error(nome_arq, "arquivo binario truncado");
+        }
+        lidos += n;
+    }
+}
+
+// Le 'quantidade' valores de 4 ou 8 bytes do descritor fd a partir de deslocamento, convertidos para double
+static void read_values(int fd, const char *nome_arq, double *destino, long quantidade, int precisao, off_t deslocamento,
+                        float *temp)
+{
+    read_exact(fd, nome_arq, precisao == 8 ? (void *)destino : (void *)temp, (size_t)quantidade * precisao, deslocamento);
+    if (precisao == 4)
+    {
+        for (long k = 0; k < quantidade; k++)
+        {
+            destino[k] = temp[k];
+        }
+    }
+}
+
+// Carrega o formato binario: no layout denso cada thread le as suas linhas com pread
+static int load_binary(jacobi_contexto *ctx, const char *nome_arq, const jacobi_cabecalho *cab)
+{
+    int N = ctx->N;
+    int ld = ctx->ld;
+    int T = ctx->T;
+    double *matrix = ctx->matrix;
+    off_t dados = sizeof(jacobi_cabecalho);
+
+    int fd = open(nome_arq, O_RDONLY);
+    if (fd < 0)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+
+    if (cab->layout == LAYOUT_DENSO)
+    {
+        if (cab->nnz != (int64_t)N * N)
+        {
+            file_error(nome_arq, "layout denso deve ter N*N valores");
+        }
+#pragma omp parallel num_threads(T)
+        {
+            float *temp = cab->precisao == 4 ? (float *)malloc(sizeof(float) * N) : NULL;
+            if (cab->precisao == 4 && temp == NULL)
+            {
+                printf("Erro de alocação de memória\n");
+                exit(1);
+            }
+#pragma omp for schedule(static)
+            for (int i = 0; i < N; i++)
+            {
+                double *linha = matrix + (size_t)i * ld;
+                read_values(fd, nome_arq, linha, N, cab->precisao, dados + (off_t)i * N * cab->precisao, temp);
+                memset(linha + N, 0, sizeof(double) * (ld - N));
+            }
+            free(temp);
+        }
+        dados += (off_t)N * N * cab->precisao;
+    }
+    else
+    {
+        long nnz = (long)cab->nnz;
+        int32_t *linhas = (int32_t *)malloc(sizeof(int32_t) * (nnz + 1));
+        int32_t *colunas = (int32_t *)malloc(sizeof(int32_t) * (nnz + 1));
+        double *valores = (double *)malloc(sizeof(double) * (nnz + 1));
+        float *temp = (float *)malloc(sizeof(float) * (nnz + 1));
+        if (linhas == NULL || colunas == NULL || valores == NULL || temp == NULL)
+        {
+            printf("Erro de alocação de memória\n");
+            exit(1);
+        }
+        read_exact(fd, nome_arq, linhas, sizeof(int32_t) * nnz, dados);
+        read_exact(fd, nome_arq, colunas, sizeof(int32_t) * nnz, dados + sizeof(int32_t) * nnz);
+        dados += 2 * sizeof(int32_t) * nnz;
+        read_values(fd, nome_arq, valores, nnz, cab->precisao, dados, temp);
+        dados += (off_t)nnz * cab->precisao;
+
+        long invalidos = 0;
+#pragma omp parallel num_threads(T)
+        {
+#pragma omp for schedule(static)
+            for (int i = 0; i < N; i++)
+            {
+                memset(matrix + (size_t)i * ld, 0, sizeof(double) * ld);
+            }
+#pragma omp for reduction(+ : invalidos)
+            for (long k = 0; k < nnz; k++)
+            {
+                if (linhas[k] < 0 || linhas[k] >= N || colunas[k] < 0 || colunas[k] >= N)
+                {
+                    invalidos++;
+                    continue;
+                }
+                matrix[(size_t)linhas[k] * ld + colunas[k]] = valores[k];
+            }
+        }
+        if (invalidos > 0)
+        {
+            file_error(nome_arq, "indices fora da matriz");
+        }
+        free(linhas);
+        free(colunas);
+        free(valores);
+        free(temp);
+    }
+
+    if (cab->tem_b)
+    {
+        float *temp = (float *)malloc(sizeof(float) * N);
+        if (temp == NULL)
+        {
+            printf("Erro de alocação de memória\n");
+            exit(1);
+        }
+        read_values(fd, nome_arq, ctx->vet_b, N, cab->precisao, dados, temp);
+        free(temp);
+    }
+
+    close(fd);
+    return cab->tem_b;
+}
+
+// Le o vetor B: N valores em texto, opcionalmente com cabecalho Matrix Market (array N x 1)
+static void read_vector(const char *nome_arq, double *vet, int N)
+{
+    char linha[1024];
+    FILE *arq = fopen(nome_arq, "r");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+
+    long posicao = 0;
+    if (fgets(linha, sizeof(linha), arq) != NULL && strncmp(linha, "%%MatrixMarket", 14) == 0)
+    {
+        // Pula comentarios e a linha de dimensoes
+        while (fgets(linha, sizeof(linha), arq) != NULL && (linha[0] == '%' || strspn(linha, " \t\r\n") == strlen(linha)))
+        {
+        }
+        posicao = ftell(arq);
+    }
+    fseek(arq, posicao, SEEK_SET);
+
+    for (int i = 0; i < N; i++)
+    {
+        if (fscanf(arq, "%lf", &vet[i]) != 1)
+        {
+            printf("Arquivo %s deve conter %d valores\n", nome_arq, N);
+            exit(1);
+        }
+    }
+    fclose(arq);
+}
+
+// Abre a imagem normalizada e le vet_diag e vet_b (ou o vetor de nome_b, normalizado pela diagonal),
+// usando vet_b como chute inicial. Retorna o descritor aberto, posicionado para a leitura da matriz, que
+// comeca em img->deslocamento_matriz
+int jacobi_open_normalized(jacobi_contexto *ctx, const char *nome_arq, const char *nome_b, jacobi_imagem *img)
+{
+    struct stat info;
+    int N = ctx->N;
+
+    FILE *arq = fopen(nome_arq, "rb");
+    if (arq == NULL || !read_image_header(arq, nome_arq, img) || img->N != N)
+    {
+        file_error(nome_arq, "imagem normalizada invalida ou de outra ordem");
+    }
+    fclose(arq);
+
+    int fd = open(nome_arq, O_RDONLY);
+    if (fd < 0 || fstat(fd, &info) != 0)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+    if ((uint64_t)info.st_size < img->deslocamento_matriz + img->bytes_matriz)
+    {
+        file_error(nome_arq, "imagem normalizada truncada");
+    }
+
+    ctx->ld = (int)img->ld;
+    read_values(fd, nome_arq, ctx->vet_diag, N, sizeof(double), (off_t)img->deslocamento_diag, NULL);
+    read_values(fd, nome_arq, ctx->vet_b, N, sizeof(double), (off_t)img->deslocamento_b, NULL);
+    if (nome_b != NULL)
+    {
+        read_vector(nome_b, ctx->vet_b, N);
+        for (int i = 0; i < N; i++)
+        {
+            ctx->vet_b[i] /= ctx->vet_diag[i];
+        }
+    }
+
+    jacobi_set_initial_guess(ctx, ctx->vet_b);
+    return fd;
+}
+
+// Mapeia a matriz da imagem normalizada direto do arquivo (MAP_PRIVATE: o arquivo nunca eh alterado e
+// somente as paginas modificadas, ex. por jacobi_update_rows, sao copiadas)
+static void map_normalized(jacobi_contexto *ctx, const char *nome_arq, const char *nome_b)
+{
+    jacobi_imagem img;
+    int fd = jacobi_open_normalized(ctx, nome_arq, nome_b, &img);
+
+    void *ptr = mmap(NULL, img.bytes_matriz, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)img.deslocamento_matriz);
+    if (ptr == MAP_FAILED)
+    {
+        printf("Erro ao mapear o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+    close(fd);
+
+    // Matriz que cabe com folga na memoria: leitura antecipada de tudo em segundo plano, e as paginas ficam
+    // no cache entre as iteracoes. Maior que isso: leitura antecipada sequencial, a cada varredura
+    double memoria = (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+    madvise(ptr, img.bytes_matriz, img.bytes_matriz < memoria / 2 ? MADV_WILLNEED : MADV_SEQUENTIAL);
+
+    ctx->matrix = (double *)ptr;
+    ctx->paginas = PAGINAS_ARQUIVO;
+    ctx->bytes_matriz = img.bytes_matriz;
+}
+
+// Carrega em ctx (ja alocado com a ordem de read_matrix_order) a matriz do arquivo nome_arq e o vetor B
+// de nome_b (NULL: o do arquivo binario ou, na falta dele, B = A.1, de modo que a solucao eh o vetor de
+// uns). Em seguida normaliza o sistema e usa o vetor B normalizado como chute inicial. A imagem
+// normalizada (ctx alocado com PAGINAS_ARQUIVO) eh mapeada e ja esta normalizada
+void jacobi_load(jacobi_contexto *ctx, const char *nome_arq, const char *nome_b)
+{
+    int N = ctx->N;
+    int ld = ctx->ld;
+    double *matrix = ctx->matrix;
+    double *vet_b = ctx->vet_b;
+    jacobi_cabecalho cab;
+    cabecalho_mm mm;
+    int tem_b = 0;
+
+    if (ctx->paginas == PAGINAS_ARQUIVO)
+    {
+        PERF_INICIO(PERF_INIT_MATRIX);
+        map_normalized(ctx, nome_arq, nome_b);
+        PERF_FIM(PERF_INIT_MATRIX);
+        return;
+    }
+
+    FILE *arq = fopen(nome_arq, "rb");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+
+    PERF_INICIO(PERF_INIT_MATRIX);
+    if (read_binary_header(arq, nome_arq, &cab))
+    {
+        fclose(arq);
+        if (cab.N != N)
+        {
+            file_error(nome_arq, "ordem diferente da do contexto");
+        }
+        tem_b = load_binary(ctx, nome_arq, &cab);
+    }
+    else
+    {
+        rewind(arq);
+        long inicio_dados = read_mm_header(arq, nome_arq, &mm);
+        fclose(arq);
+        if (mm.N != N)
+        {
+            file_error(nome_arq, "ordem diferente da do contexto");
+        }
+
+        int fd = open(nome_arq, O_RDONLY);
+        struct stat info;
+        if (fd < 0 || fstat(fd, &info) != 0)
+        {
+            printf("Erro ao abrir o arquivo %s\n", nome_arq);
+            exit(1);
+        }
+        size_t tamanho = (size_t)info.st_size;
+        const char *dados = (const char *)mmap(NULL, tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (dados == MAP_FAILED)
+        {
+            printf("Erro ao mapear o arquivo %s\n", nome_arq);
+            exit(1);
+        }
+        madvise((void *)dados, tamanho, MADV_SEQUENTIAL);
+        parse_mm(ctx, nome_arq, &mm, dados, tamanho, inicio_dados);
+        munmap((void *)dados, tamanho);
+    }
+
+    if (nome_b != NULL)
+    {
+        read_vector(nome_b, vet_b, N);
+    }
+
+    // Diagonal nao nula (exigida pelo metodo), dominancia diagonal e B = A.1 quando nao ha vetor B
+    long diagonal_nula = -1;
+    long nao_dominantes = 0;
+#pragma omp parallel for num_threads(ctx->T) reduction(max : diagonal_nula) reduction(+ : nao_dominantes)
+    for (int i = 0; i < N; i++)
+    {
+        const double *linha = matrix + (size_t)i * ld;
+        double soma = 0;
+        double soma_abs = 0;
+        for (int j = 0; j < N; j++)
+        {
+            soma += linha[j];
+            soma_abs += fabs(linha[j]);
+        }
+        if (linha[i] == 0)
+        {
+            diagonal_nula = i > diagonal_nula ? i : diagonal_nula;
+        }
+        nao_dominantes += fabs(linha[i]) <= soma_abs - fabs(linha[i]);
+        if (nome_b == NULL && !tem_b)
+        {
+            vet_b[i] = soma;
+        }
+    }
+    PERF_FIM(PERF_INIT_MATRIX);
+
+    if (diagonal_nula >= 0)
+    {
+        printf("Arquivo %s: diagonal nula na linha %ld (o metodo de Jacobi exige diagonal sem zeros)\n", nome_arq,
+               diagonal_nula);
+        exit(1);
+    }
+    if (nao_dominantes > 0)
+    {
+        printf("Aviso: %ld linhas sem dominancia diagonal estrita; a convergencia nao eh garantida\n", nao_dominantes);
+    }
+
+    PERF_INICIO(PERF_NORMALIZE_MATRIX);
+    normalize_matrix(matrix, vet_b, ctx->vet_diag, N, ld, ctx->T);
+    PERF_FIM(PERF_NORMALIZE_MATRIX);
+
+    jacobi_set_initial_guess(ctx, vet_b);
+}
+
+// Grava o sistema original (desfaz a normalizacao) no formato binario: layout denso, precisao dupla, com B
+void jacobi_save_binary(jacobi_contexto *ctx, const char *nome_arq)
+{
+    int N = ctx->N;
+    jacobi_cabecalho cab;
+
+    FILE *arq = fopen(nome_arq, "wb");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+    double *linha = (double *)malloc(sizeof(double) * N);
+    if (linha == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+
+    memset(&cab, 0, sizeof(cab));
+    memcpy(cab.magica, MAGICA_BINARIO, sizeof(cab.magica));
+    cab.versao = VERSAO_BINARIO;
+    cab.precisao = sizeof(double);
+    cab.layout = LAYOUT_DENSO;
+    cab.tem_b = 1;
+    cab.N = N;
+    cab.nnz = (int64_t)N * N;
+    fwrite(&cab, sizeof(cab), 1, arq);
+
+    for (int i = 0; i < N; i++)
+    {
+        const double *normalizada = ctx->matrix + (size_t)i * ctx->ld;
+        for (int j = 0; j < N; j++)
+        {
+            linha[j] = normalizada[j] * ctx->vet_diag[i];
+        }
+        linha[i] = ctx->vet_diag[i];
+        fwrite(linha, sizeof(double), N, arq);
+    }
+    for (int i = 0; i < N; i++)
+    {
+        linha[i] = ctx->vet_b[i] * ctx->vet_diag[i];
+    }
+    fwrite(linha, sizeof(double), N, arq);
+
+    free(linha);
+    if (fclose(arq) != 0)
+    {
+        printf("Erro ao gravar o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+}
+
+// Cabecalho da imagem normalizada de ordem N com distancia ld entre as linhas da matriz
+static void image_layout(jacobi_imagem *img, int N, int ld)
+{
+    memset(img, 0, sizeof(*img));
+    memcpy(img->magica, MAGICA_NORMALIZADA, sizeof(img->magica));
+    img->versao = VERSAO_NORMALIZADA;
+    img->bytes_double = sizeof(double);
+    img->N = N;
+    img->ld = ld;
+    img->bytes_matriz = (uint64_t)N * ld * sizeof(double);
+    img->deslocamento_diag = ALINHAMENTO_SECAO;
+    img->deslocamento_b = (img->deslocamento_diag + sizeof(double) * N + ALINHAMENTO_SECAO - 1) / ALINHAMENTO_SECAO * ALINHAMENTO_SECAO;
+    img->deslocamento_matriz = (img->deslocamento_b + sizeof(double) * N + ALINHAMENTO_SECAO - 1) / ALINHAMENTO_SECAO * ALINHAMENTO_SECAO;
+}
+
+// Grava o sistema normalizado de ctx como imagem mapeavel (ver jacobi_imagem). A imagem eh escrita em um
+// arquivo temporario e renomeada, de modo que quem ja mapeou uma versao anterior nao a ve truncada
+void jacobi_save_normalized(jacobi_contexto *ctx, const char *nome_arq)
+{
+    int N = ctx->N;
+    jacobi_imagem img;
+    char temporario[4096];
+
+    image_layout(&img, N, ctx->ld);
+
+    snprintf(temporario, sizeof(temporario), "%s.%d.tmp", nome_arq, (int)getpid());
+    FILE *arq = fopen(temporario, "wb");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", temporario);
+        exit(1);
+    }
+
+    // Os trechos entre as secoes ficam como buracos (zeros) no arquivo
+    int ok = fwrite(&img, sizeof(img), 1, arq) == 1;
+    ok = ok && fseeko(arq, (off_t)img.deslocamento_diag, SEEK_SET) == 0 && fwrite(ctx->vet_diag, sizeof(double), N, arq) == (size_t)N;
+    ok = ok && fseeko(arq, (off_t)img.deslocamento_b, SEEK_SET) == 0 && fwrite(ctx->vet_b, sizeof(double), N, arq) == (size_t)N;
+    ok = ok && fseeko(arq, (off_t)img.deslocamento_matriz, SEEK_SET) == 0 &&
+         fwrite(ctx->matrix, 1, img.bytes_matriz, arq) == img.bytes_matriz;
+    ok = fclose(arq) == 0 && ok;
+    if (!ok || rename(temporario, nome_arq) != 0)
+    {
+        remove(temporario);
+        printf("Erro ao gravar o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+}
+
+// Gera o sistema de jacobi_generate (mesma seed, mesmos valores) e grava a sua imagem normalizada sem
+// que a matriz passe inteira pela memoria: cada painel de ate bytes_painel bytes de linhas eh gerado,
+// normalizado e gravado antes do proximo. Somente o painel e os vetores ficam na memoria, de modo que a
+// imagem pode ser maior que ela (ver --fora-da-memoria). Gravada em temporario e renomeada, como em
+// jacobi_save_normalized
+void jacobi_generate_normalized(const char *nome_arq, int N, int seed, size_t bytes_painel, int T)
+{
+    int ld = leading_dimension(N);
+    size_t bytes_linha = sizeof(double) * ld;
+    jacobi_imagem img;
+    char temporario[4096];
+
+    int linhas_painel = bytes_painel / bytes_linha > 0 ? (int)(bytes_painel / bytes_linha) : 1;
+    if (linhas_painel > N)
+    {
+        linhas_painel = N;
+    }
+    double *painel = (double *)alloc_aligned(linhas_painel * bytes_linha);
+    double *vet_b = (double *)alloc_aligned(sizeof(double) * N);
+    double *vet_diag = (double *)alloc_aligned(sizeof(double) * N);
+    if (painel == NULL || vet_b == NULL || vet_diag == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+
+    image_layout(&img, N, ld);
+    snprintf(temporario, sizeof(temporario), "%s.%d.tmp", nome_arq, (int)getpid());
+    FILE *arq = fopen(temporario, "wb");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", temporario);
+        exit(1);
+    }
+
+    // Imagem maior que metade da memoria (como em stream_init): cada painel gravado eh descarregado no
+    // disco e sai do cache de paginas, para que a gravacao nao ocupe a memoria com paginas sujas
+    int fd = fileno(arq);
+    double memoria = (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+    int descartar = img.bytes_matriz >= memoria / 2;
+    srand(seed);
+    int ok = fwrite(&img, sizeof(img), 1, arq) == 1 && fseeko(arq, (off_t)img.deslocamento_matriz, SEEK_SET) == 0;
+    for (int i0 = 0; ok && i0 < N; i0 += linhas_painel)
+    {
+        int i1 = i0 + linhas_painel < N ? i0 + linhas_painel : N;
+        size_t bytes = (size_t)(i1 - i0) * bytes_linha;
+        init_rows(painel, vet_b + i0, i0, i1, N, ld);
+        normalize_rows(painel, vet_b + i0, vet_diag + i0, i0, i1, ld, T);
+        ok = fwrite(painel, 1, bytes, arq) == bytes;
+        if (ok && descartar)
+        {
+            ok = fflush(arq) == 0 && fdatasync(fd) == 0;
+            posix_fadvise(fd, (off_t)img.deslocamento_matriz + (off_t)i0 * bytes_linha, bytes, POSIX_FADV_DONTNEED);
+        }
+    }
+    ok = ok && fseeko(arq, (off_t)img.deslocamento_diag, SEEK_SET) == 0 && fwrite(vet_diag, sizeof(double), N, arq) == (size_t)N;
+    ok = ok && fseeko(arq, (off_t)img.deslocamento_b, SEEK_SET) == 0 && fwrite(vet_b, sizeof(double), N, arq) == (size_t)N;
+    ok = fclose(arq) == 0 && ok;
+    free_aligned(painel);
+    free_aligned(vet_b);
+    free_aligned(vet_diag);
+    if (!ok || rename(temporario, nome_arq) != 0)
+    {
+        remove(temporario);
+        printf("Erro ao gravar o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+}
+
+// Formato de gravacao pela extensao: .npy, .txt ou .csv (texto); qualquer outra, binario
+int output_format(const char *nome_arq)
+{
+    const char *ponto = strrchr(nome_arq, '.');
+    if (ponto != NULL && strcasecmp(ponto, ".npy") == 0)
+    {
+        return SAIDA_NPY;
+    }
+    if (ponto != NULL && (strcasecmp(ponto, ".txt") == 0 || strcasecmp(ponto, ".csv") == 0))
+    {
+        return SAIDA_TEXTO;
+    }
+    return SAIDA_BINARIA;
+}
+
+// Cabecalho NPY 1.0: magica, versao, tamanho do dicionario e o dicionario, completado com espacos ate um
+// multiplo de 64 bytes e terminado em '\n'
+static int write_npy_header(FILE *arq, int N)
+{
+    const uint16_t um = 1;
+    char dicionario[128];
+    int tamanho = snprintf(dicionario, sizeof(dicionario), "{'descr': '%cf8', 'fortran_order': False, 'shape': (%d,), }",
+                           *(const char *)&um ? '<' : '>', N);
+    int total = (10 + tamanho + 1 + 63) / 64 * 64;
+    uint16_t tamanho_cabecalho = (uint16_t)(total - 10);
+    unsigned char prefixo[10] = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0, (unsigned char)(tamanho_cabecalho & 0xff),
+                                 (unsigned char)(tamanho_cabecalho >> 8)};
+
+    memset(dicionario + tamanho, ' ', total - 10 - tamanho - 1);
+    dicionario[total - 11] = '\n';
+    return fwrite(prefixo, 1, 10, arq) == 10 && fwrite(dicionario, 1, total - 10, arq) == (size_t)(total - 10);
+}
+
+// Thread de gravacao: escreve a copia do vetor em blocos de BLOCO_SAIDA elementos (no texto, cada bloco eh
+// formatado em um buffer e escrito de uma vez)
+static void *write_output(void *arg)
+{
+    jacobi_saida *saida = (jacobi_saida *)arg;
+    char *texto = NULL;
+
+    FILE *arq = fopen(saida->nome_arq, saida->formato == SAIDA_TEXTO ? "w" : "wb");
+    int ok = arq != NULL;
+    if (ok && saida->formato == SAIDA_NPY)
+    {
+        ok = write_npy_header(arq, saida->N);
+    }
+    if (ok && saida->formato == SAIDA_TEXTO)
+    {
+        texto = (char *)malloc((size_t)BLOCO_SAIDA * 32);
+        ok = texto != NULL;
+    }
+
+    for (int i0 = 0; ok && i0 < saida->N; i0 += BLOCO_SAIDA)
+    {
+        int i1 = i0 + BLOCO_SAIDA < saida->N ? i0 + BLOCO_SAIDA : saida->N;
+        if (saida->formato == SAIDA_TEXTO)
+        {
+            size_t usados = 0;
+            for (int i = i0; i < i1; i++)
+            {
+                usados += snprintf(texto + usados, 32, "%.17g\n", saida->vet[i]);
+            }
+            ok = fwrite(texto, 1, usados, arq) == usados;
+        }
+        else
+        {
+            ok = fwrite(saida->vet + i0, sizeof(double), i1 - i0, arq) == (size_t)(i1 - i0);
+        }
+    }
+
+    if (arq != NULL)
+    {
+        ok = fclose(arq) == 0 && ok;
+    }
+    free(texto);
+    saida->ok = ok;
+    return NULL;
+}
+
+// Inicia a gravacao de uma copia de vet (N elementos) em nome_arq no formato SAIDA_*. O chamador segue
+// (ex.: preparando o proximo sistema) e chama output_finish antes de sair
+void output_start(jacobi_saida *saida, const char *nome_arq, int formato, const double *vet, int N)
+{
+    saida->nome_arq = nome_arq;
+    saida->formato = formato;
+    saida->N = N;
+    saida->ok = 0;
+    saida->vet = (double *)alloc_aligned(sizeof(double) * N);
+    if (saida->vet == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+    memcpy(saida->vet, vet, sizeof(double) * N);
+    pthread_attr_t atributos;
+    helper_thread_attr(&atributos); // mascara original, nao a cpu da thread mestre
+    if (pthread_create(&saida->gravador, &atributos, write_output, saida) != 0)
+    {
+        printf("Erro ao criar a thread de gravacao\n");
+        exit(1);
+    }
+    pthread_attr_destroy(&atributos);
+}
+
+// Espera a gravacao terminar. Retorna 0 se ela falhou
+int output_finish(jacobi_saida *saida)
+{
+    pthread_join(saida->gravador, NULL);
+    free_aligned(saida->vet);
+    return saida->ok;
+}
+
+const char *cache_dir(void)
+{
+    const char *dir = getenv("JACOBI_CACHE");
+    return dir != NULL ? dir : DIRETORIO_CACHE;
+}
+
+// Nome em dir da imagem do sistema gerado com (N, seed), com as versoes da imagem e do gerador (o gerador
+// usa rand(), entao o cache so vale para a biblioteca C que o gravou). Retorna 1 se a imagem ja existe
+int cache_lookup(const char *dir, int N, int seed, char *nome_arq, size_t tamanho)
+{
+    snprintf(nome_arq, tamanho, "%s/jacobi_n%d_s%d_v%d_g%d.jn", dir, N, seed, VERSAO_NORMALIZADA, VERSAO_GERADOR);
+    return access(nome_arq, R_OK) == 0;
+}
+
+// Cria o diretorio do cache, se ainda nao existe. Retorna 0 se ele nao existe nem pode ser criado
+int cache_create_dir(const char *dir)
+{
+    if (mkdir(dir, 0777) != 0 && access(dir, W_OK) != 0)
+    {
+        printf("Nao foi possivel criar o diretorio de cache %s\n", dir);
+        return 0;
+    }
+    return 1;
+}
+
+// Grava o sistema recem-gerado de ctx no cache (criando o diretorio). Execucoes simultaneas com a mesma
+// chave nao se atrapalham: cada uma escreve o seu temporario e a ultima renomeacao prevalece
+void cache_store(jacobi_contexto *ctx, const char *dir, const char *nome_arq)
+{
+    if (cache_create_dir(dir))
+    {
+        jacobi_save_normalized(ctx, nome_arq);
+    }
+}
@@ -0,0 +1,91 @@
+// Leitura de sistemas reais: Matrix Market (.mtx, coordinate e array, general e symmetric), com o texto
+// dividido entre as threads, e formato binario nativo com cabecalho (N, nnz, precisao, layout). A imagem
+// normalizada guarda o sistema ja normalizado exatamente como na memoria e eh mapeada sem copia; o cache
+// de sistemas gerados guarda uma imagem por (N, seed). Vetores (solucao, residuo) sao gravados em binario,
+// NPY ou texto por uma thread, em blocos, enquanto o programa segue
+
+#ifndef JACOBIIO_H
+#define JACOBIIO_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+#include "jacobipar.h"
+
+#define MAGICA_BINARIO "JACOBIB" // 8 bytes, com o '\0'
+#define VERSAO_BINARIO 1
+#define MAGICA_NORMALIZADA "JACOBIN"
+#define VERSAO_NORMALIZADA 1
+#define ALINHAMENTO_SECAO 65536 // secoes da imagem normalizada (multiplo das paginas de 4 e 64 KiB)
+#define VERSAO_GERADOR 1        // sistema gerado por init_matrix (mudar quando a geracao mudar)
+#define DIRETORIO_CACHE "jacobi_cache" // cache de sistemas gerados, se JACOBI_CACHE nao estiver definida
+
+// Formatos reconhecidos por read_matrix_order
+#define FORMATO_MATRIX_MARKET 0
+#define FORMATO_BINARIO 1
+#define FORMATO_NORMALIZADO 2
+
+// Formatos de gravacao de vetores, escolhidos pela extensao do arquivo (output_format)
+#define SAIDA_BINARIA 0    // N doubles, na ordem de bytes da maquina
+#define SAIDA_NPY 1        // .npy: vetor float64 de N elementos legivel por numpy.load
+#define SAIDA_TEXTO 2      // .txt, .csv: um valor por linha com 17 digitos significativos (legivel por --chute)
+#define BLOCO_SAIDA 65536  // elementos por bloco gravado
+
+// Layouts do formato binario
+#define LAYOUT_DENSO 0       // N*N valores, linha a linha
+#define LAYOUT_COORDENADAS 1 // nnz linhas (int32), nnz colunas (int32) e nnz valores, indices a partir de 0
+
+// Cabecalho do formato binario, seguido da matriz e, se tem_b, dos N valores do vetor B (mesma precisao)
+typedef struct
+{
+    char magica[8];    // MAGICA_BINARIO
+    uint32_t versao;   // VERSAO_BINARIO
+    uint32_t precisao; // bytes por valor: 4 (float) ou 8 (double)
+    uint32_t layout;   // LAYOUT_DENSO ou LAYOUT_COORDENADAS
+    uint32_t tem_b;    // 1 se o vetor B segue a matriz
+    int64_t N;         // ordem da matriz
+    int64_t nnz;       // valores armazenados (N*N no layout denso)
+} jacobi_cabecalho;
+
+// Cabecalho da imagem normalizada. As secoes comecam em deslocamentos multiplos de ALINHAMENTO_SECAO:
+// vet_diag (N valores), vet_b normalizado (N valores) e a matriz normalizada (N linhas de ld valores,
+// diagonal zerada), todas em double e na ordem de bytes da maquina que gravou
+typedef struct
+{
+    char magica[8];               // MAGICA_NORMALIZADA
+    uint32_t versao;              // VERSAO_NORMALIZADA
+    uint32_t bytes_double;        // sizeof(double), para rejeitar imagens de outra representacao
+    int64_t N;                    // ordem da matriz
+    int64_t ld;                   // distancia entre linhas da matriz
+    uint64_t deslocamento_diag;   // secao de vet_diag
+    uint64_t deslocamento_b;      // secao de vet_b
+    uint64_t deslocamento_matriz; // secao da matriz
+    uint64_t bytes_matriz;        // N * ld * sizeof(double)
+} jacobi_imagem;
+
+// Gravacao de um vetor em segundo plano (output_start / output_finish)
+typedef struct
+{
+    const char *nome_arq;
+    int formato;        // SAIDA_*
+    double *vet;        // copia do vetor, livre para o chamador alterar o original
+    int N;
+    int ok;             // gravacao concluida sem erro
+    pthread_t gravador;
+} jacobi_saida;
+
+int read_matrix_order(const char *nome_arq, int *formato);
+void jacobi_load(jacobi_contexto *ctx, const char *nome_arq, const char *nome_b);
+int jacobi_open_normalized(jacobi_contexto *ctx, const char *nome_arq, const char *nome_b, jacobi_imagem *img);
+void jacobi_save_binary(jacobi_contexto *ctx, const char *nome_arq);
+void jacobi_save_normalized(jacobi_contexto *ctx, const char *nome_arq);
+void jacobi_generate_normalized(const char *nome_arq, int N, int seed, size_t bytes_painel, int T);
+int output_format(const char *nome_arq);
+void output_start(jacobi_saida *saida, const char *nome_arq, int formato, const double *vet, int N);
+int output_finish(jacobi_saida *saida);
+const char *cache_dir(void);
+int cache_create_dir(const char *dir);
+int cache_lookup(const char *dir, int N, int seed, char *nome_arq, size_t tamanho);
+void cache_store(jacobi_contexto *ctx, const char *dir, const char *nome_arq);
+
+#endif
@@ -0,0 +1,184 @@
+// Alocacao alinhada e em paginas enormes (mmap com MAP_HUGETLB ou madvise(MADV_HUGEPAGE) no Linux)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "jacobimem.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+#define MAP_HUGE_2M (21 << MAP_HUGE_SHIFT) // log2 do tamanho da pagina
+#define MAP_HUGE_1G (30 << MAP_HUGE_SHIFT)
+#endif
+
+const char *nome_paginas[] = {"normais", "thp", "2m", "1g", "arquivo", "nenhuma"};
+
+// Bloco de 'bytes' alinhado em ALINHAMENTO bytes (NULL se faltar memoria). Liberar com free_aligned
+void *alloc_aligned(size_t bytes)
+{
+#ifdef _WIN32
+    return _aligned_malloc(bytes > 0 ? bytes : 1, ALINHAMENTO);
+#else
+    void *ptr;
+    return posix_memalign(&ptr, ALINHAMENTO, bytes > 0 ? bytes : 1) == 0 ? ptr : NULL;
+#endif
+}
+
+void free_aligned(void *ptr)
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// Distancia (em doubles) entre linhas consecutivas da matriz: N arredondado para linhas de cache
+// inteiras (cada linha comeca alinhada) e, quando o tamanho da linha eh multiplo de PASSO_CRITICO (N
+// potencia de 2), acrescido de uma linha de cache para que linhas vizinhas nao disputem os mesmos
+// conjuntos da cache
+int leading_dimension(int N)
+{
+    int por_linha = ALINHAMENTO / sizeof(double);
+    int ld = (N + por_linha - 1) / por_linha * por_linha;
+    if ((ld * sizeof(double)) % PASSO_CRITICO == 0)
+    {
+        ld += por_linha;
+    }
+    return ld;
+}
+
+// Tipo de pagina pelo nome (normais, thp, 2m, 1g), -1 se desconhecido
+int parse_pages(const char *texto)
+{
+    for (int p = PAGINAS_NORMAIS; p <= PAGINAS_1G; p++)
+    {
+        if (strcmp(texto, nome_paginas[p]) == 0)
+        {
+            return p;
+        }
+    }
+    return -1;
+}
+
+// Granularidade do mapeamento da matriz (alinhamento exigido por mbind e madvise em trechos dela)
+size_t page_size(int paginas)
+{
+#ifdef __linux__
+    if (paginas == PAGINAS_1G)
+    {
+        return PAGINA_GIGANTE;
+    }
+    if (paginas == PAGINAS_2M)
+    {
+        return PAGINA_ENORME;
+    }
+    return (size_t)sysconf(_SC_PAGESIZE);
+#else
+    return 4096;
+#endif
+}
+
+#ifdef __linux__
+
+// Mapeamento anonimo de 'bytes' alinhado em 'alinhamento' (as sobras antes e depois sao devolvidas)
+static void *map_aligned(size_t bytes, size_t alinhamento)
+{
+    size_t total = bytes + alinhamento;
+    char *ptr = (char *)mmap(NULL, total, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED)
+    {
+        return NULL;
+    }
+    char *inicio = (char *)(((uintptr_t)ptr + alinhamento - 1) / alinhamento * alinhamento);
+    if (inicio > ptr)
+    {
+        munmap(ptr, inicio - ptr);
+    }
+    if (ptr + total > inicio + bytes)
+    {
+        munmap(inicio + bytes, ptr + total - (inicio + bytes));
+    }
+    return inicio;
+}
+
+// Matriz de 'bytes' em paginas do tipo pedido ou, na falta delas, do maior tipo menor disponivel.
+// obtidas recebe o tipo usado e reservados o tamanho reservado (a passar para free_matrix)
+double *alloc_matrix(size_t bytes, int paginas, int *obtidas, size_t *reservados)
+{
+    void *ptr;
+
+    if (paginas == PAGINAS_1G)
+    {
+        *reservados = (bytes + PAGINA_GIGANTE - 1) / PAGINA_GIGANTE * PAGINA_GIGANTE;
+        ptr = mmap(NULL, *reservados, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_1G, -1, 0);
+        if (ptr != MAP_FAILED)
+        {
+            *obtidas = PAGINAS_1G;
+            return (double *)ptr;
+        }
+        paginas = PAGINAS_2M;
+    }
+
+    if (paginas == PAGINAS_2M)
+    {
+        *reservados = (bytes + PAGINA_ENORME - 1) / PAGINA_ENORME * PAGINA_ENORME;
+        ptr = mmap(NULL, *reservados, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_HUGE_2M, -1, 0);
+        if (ptr != MAP_FAILED)
+        {
+            *obtidas = PAGINAS_2M;
+            return (double *)ptr;
+        }
+        paginas = PAGINAS_THP;
+    }
+
+    // Paginas transparentes: trecho alinhado em 2 MiB para que o kernel possa usar paginas enormes
+    // desde o primeiro acesso. Matrizes menores que uma pagina enorme ficam em paginas normais
+    if (paginas == PAGINAS_THP && bytes >= PAGINA_ENORME)
+    {
+        *reservados = (bytes + PAGINA_ENORME - 1) / PAGINA_ENORME * PAGINA_ENORME;
+        ptr = map_aligned(*reservados, PAGINA_ENORME);
+        if (ptr != NULL)
+        {
+            *obtidas = madvise(ptr, *reservados, MADV_HUGEPAGE) == 0 ? PAGINAS_THP : PAGINAS_NORMAIS;
+            return (double *)ptr;
+        }
+    }
+
+    size_t pagina = (size_t)sysconf(_SC_PAGESIZE);
+    *reservados = (bytes + pagina - 1) / pagina * pagina;
+    *obtidas = PAGINAS_NORMAIS;
+    ptr = map_aligned(*reservados, pagina);
+    return (double *)ptr;
+}
+
+void free_matrix(double *matrix, int paginas, size_t reservados)
+{
+    if (matrix != NULL)
+    {
+        munmap(matrix, reservados);
+    }
+}
+
+#else
+
+double *alloc_matrix(size_t bytes, int paginas, int *obtidas, size_t *reservados)
+{
+    *obtidas = PAGINAS_NORMAIS;
+    *reservados = bytes;
+    return (double *)alloc_aligned(bytes);
+}
+
+void free_matrix(double *matrix, int paginas, size_t reservados)
+{
+    free_aligned(matrix);
+}
+
+#endif
@@ -0,0 +1,32 @@
+// Camada de alocacao: vetores alinhados em 64 bytes e matriz em paginas enormes (transparentes ou
+// explicitas de 2 MiB / 1 GiB), com a distancia entre linhas ajustada para evitar aliasing na cache
+
+#ifndef JACOBIMEM_H
+#define JACOBIMEM_H
+
+#include <stddef.h>
+
+#define ALINHAMENTO 64                   // bytes: linha de cache e largura de um vetor AVX-512
+#define PAGINA_ENORME (2UL << 20)        // 2 MiB
+#define PAGINA_GIGANTE (1UL << 30)       // 1 GiB
+#define PASSO_CRITICO 4096               // linhas com tamanho multiplo deste passo caem nos mesmos conjuntos da L1
+
+// Tipos de pagina da matriz. Na falta do tipo pedido, a alocacao tenta o proximo menor
+#define PAGINAS_NORMAIS 0
+#define PAGINAS_THP 1 // paginas enormes transparentes (madvise), padrao
+#define PAGINAS_2M 2  // hugetlbfs de 2 MiB (requer paginas reservadas em /proc/sys/vm/nr_hugepages)
+#define PAGINAS_1G 3  // hugetlbfs de 1 GiB
+#define PAGINAS_ARQUIVO 4 // matriz mapeada de um arquivo (nao alocada por alloc_matrix)
+#define PAGINAS_SEM_MATRIZ 5 // matriz nao armazenada (regenerada a cada varredura)
+
+extern const char *nome_paginas[];
+
+void *alloc_aligned(size_t bytes);
+void free_aligned(void *ptr);
+int leading_dimension(int N);
+int parse_pages(const char *texto);
+size_t page_size(int paginas);
+double *alloc_matrix(size_t bytes, int paginas, int *obtidas, size_t *reservados);
+void free_matrix(double *matrix, int paginas, size_t reservados);
+
+#endif
@@ -0,0 +1,177 @@
+// Alocacao das linhas da matriz e das replicas do vetor X nos nos NUMA das threads (somente Linux), com
+// as chamadas de sistema getcpu e mbind
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <omp.h>
+
+#include "jacobinuma.h"
+
+#ifdef __linux__
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#define BITS_PALAVRA (8 * sizeof(unsigned long))
+
+// Restringe as paginas de [inicio, fim) ao no 'no', migrando as que ja estao em outro no quando mover
+static int bind_pages(void *inicio, void *fim, int no, int mover)
+{
+    unsigned long mascara[MAX_NO_SISTEMA / BITS_PALAVRA] = {0};
+    if ((char *)fim <= (char *)inicio)
+    {
+        return 1;
+    }
+    // A mascara tem palavras ate a do bit do no; maxnode conta um bit a mais: o kernel descarta o ultimo
+    // bit da mascara
+    int palavras = no / BITS_PALAVRA + 1;
+    mascara[no / BITS_PALAVRA] = 1UL << (no % BITS_PALAVRA);
+    return syscall(SYS_mbind, inicio, (unsigned long)((char *)fim - (char *)inicio), MPOL_BIND, mascara,
+                   palavras * BITS_PALAVRA + 1, mover ? MPOL_MF_MOVE : 0) == 0;
+}
+
+// Descobre o no de cada thread (fixada pela afinidade), aloca uma replica de X em cada no e migra as
+// linhas de cada thread (particao estatica do laco de linhas de ctx->kernel) para o seu no. Retorna 0 se
+// o sistema nao suporta mbind ou a configuracao nao cabe nos limites
+int numa_setup(jacobi_numa *numa, jacobi_contexto *ctx)
+{
+    int N = ctx->N;
+    int T = ctx->T;
+    int no_cpu[MAX_THREADS_NUMA];
+    int primeira[MAX_THREADS_NUMA];
+    int ultima[MAX_THREADS_NUMA];
+    int ok = 1;
+
+    if (T > MAX_THREADS_NUMA)
+    {
+        return 0;
+    }
+    memset(numa, 0, sizeof(*numa));
+    numa->T = T;
+
+    int R = ctx->kernel.variante == KERNEL_BLOCOS ? ctx->kernel.bloco_linhas : 1;
+    int num_blocos = (N + R - 1) / R;
+
+    // No de cada thread e trecho de linhas que ela percorre na varredura
+#pragma omp parallel num_threads(T)
+    {
+        int t = omp_get_thread_num();
+        unsigned cpu, no;
+        no_cpu[t] = syscall(SYS_getcpu, &cpu, &no, NULL) == 0 ? (int)no : 0;
+        primeira[t] = N;
+        ultima[t] = -1;
+#pragma omp for schedule(static)
+        for (int g = 0; g < num_blocos; g++)
+        {
+            primeira[t] = primeira[t] < g * R ? primeira[t] : g * R;
+            ultima[t] = g * R + R - 1 < N ? g * R + R - 1 : N - 1;
+        }
+    }
+
+    for (int t = 0; t < T; t++)
+    {
+        int k = 0;
+        while (k < numa->num_nos && numa->no_sistema[k] != no_cpu[t])
+        {
+            k++;
+        }
+        if (k == numa->num_nos)
+        {
+            if (k == MAX_NOS_NUMA || no_cpu[t] >= MAX_NO_SISTEMA)
+            {
+                return 0;
+            }
+            numa->no_sistema[numa->num_nos++] = no_cpu[t];
+        }
+        numa->no_thread[t] = k;
+        numa->posicao_thread[t] = numa->threads_no[k]++;
+        if (ultima[t] >= primeira[t])
+        {
+            numa->linhas_no[k] += ultima[t] - primeira[t] + 1;
+        }
+    }
+
+    // Replicas de X, alocadas no no antes do primeiro acesso
+    long pagina = sysconf(_SC_PAGESIZE);
+    numa->bytes_replica = (sizeof(double) * N + pagina - 1) / pagina * pagina;
+    int ld = ctx->ld;
+    for (int k = 0; k < numa->num_nos; k++)
+    {
+        void *replica = mmap(NULL, numa->bytes_replica, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (replica == MAP_FAILED)
+        {
+            printf("Erro de alocação de memória\n");
+            exit(1);
+        }
+        numa->vet_x_no[k] = (double *)replica;
+        ok &= bind_pages(replica, (char *)replica + numa->bytes_replica, numa->no_sistema[k], 0);
+        memcpy(numa->vet_x_no[k], ctx->vet_x, sizeof(double) * N);
+    }
+
+    // Paginas da matriz (de 4 KiB, 2 MiB ou 1 GiB, conforme a alocacao): a pagina que comeca dentro das
+    // linhas da thread t vai para o no de t. Vizinhas calculam a mesma fronteira, entao cada pagina eh
+    // migrada por uma unica thread
+    pagina = (long)page_size(ctx->paginas);
+    uintptr_t inicio_matriz = (uintptr_t)ctx->matrix / pagina * pagina;
+    uintptr_t fim_matriz = ((uintptr_t)(ctx->matrix + (size_t)N * ld) + pagina - 1) / pagina * pagina;
+#pragma omp parallel num_threads(T) reduction(& : ok)
+    {
+        int t = omp_get_thread_num();
+        if (ultima[t] >= primeira[t])
+        {
+            uintptr_t inicio = ((uintptr_t)(ctx->matrix + (size_t)primeira[t] * ld) + pagina - 1) / pagina * pagina;
+            uintptr_t fim = ((uintptr_t)(ctx->matrix + (size_t)(ultima[t] + 1) * ld) + pagina - 1) / pagina * pagina;
+            inicio = primeira[t] == 0 ? inicio_matriz : inicio;
+            fim = ultima[t] == N - 1 ? fim_matriz : fim;
+            ok &= bind_pages((void *)inicio, (void *)fim, no_cpu[t], 1);
+        }
+    }
+
+    if (!ok)
+    {
+        numa_free(numa);
+    }
+    return ok;
+}
+
+void numa_free(jacobi_numa *numa)
+{
+    for (int k = 0; k < numa->num_nos; k++)
+    {
+        if (numa->vet_x_no[k] != NULL)
+        {
+            munmap(numa->vet_x_no[k], numa->bytes_replica);
+            numa->vet_x_no[k] = NULL;
+        }
+    }
+    numa->num_nos = 0;
+}
+
+#else
+
+int numa_setup(jacobi_numa *numa, jacobi_contexto *ctx)
+{
+    memset(numa, 0, sizeof(*numa));
+    return 0;
+}
+
+void numa_free(jacobi_numa *numa)
+{
+}
+
+#endif
+
+// Distribuicao das threads e das linhas da matriz entre os nos
+void numa_report(const jacobi_numa *numa, FILE *arq)
+{
+    fprintf(arq, "NUMA: %d no(s) em uso\n", numa->num_nos);
+    for (int k = 0; k < numa->num_nos; k++)
+    {
+        fprintf(arq, "  no %d: %d thread(s), %ld linhas da matriz, replica de X com %zu bytes\n", numa->no_sistema[k],
+                numa->threads_no[k], numa->linhas_no[k], numa->bytes_replica);
+    }
+}
@@ -0,0 +1,35 @@
+// Modo NUMA: as linhas da matriz de cada thread ficam no no de memoria da cpu em que a thread esta fixada
+// (mbind com migracao das paginas) e cada no guarda uma replica do vetor X, atualizada uma vez por
+// iteracao no inicio de calculate_new_x. A varredura le X somente da replica local: o trafego entre nos
+// cai para a copia de O(N) elementos por no e por iteracao. Requer threads fixadas (--afinidade)
+
+#ifndef JACOBINUMA_H
+#define JACOBINUMA_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "jacobipar.h"
+
+#define MAX_NOS_NUMA 64       // nos em uso por um time
+#define MAX_NO_SISTEMA 1024   // limite do numero de um no no sistema (NODES_SHIFT = 10 no kernel)
+#define MAX_THREADS_NUMA 1024
+
+typedef struct jacobi_numa
+{
+    int T;                                // threads do time da varredura
+    int num_nos;                          // nos com pelo menos uma thread
+    int no_sistema[MAX_NOS_NUMA];         // numero de cada no no sistema
+    int threads_no[MAX_NOS_NUMA];         // threads em cada no
+    long linhas_no[MAX_NOS_NUMA];         // linhas da matriz alocadas em cada no
+    double *vet_x_no[MAX_NOS_NUMA];       // replica do vetor X alocada em cada no
+    size_t bytes_replica;                 // tamanho de cada replica (multiplo da pagina)
+    int no_thread[MAX_THREADS_NUMA];      // indice (em no_sistema) do no de cada thread
+    int posicao_thread[MAX_THREADS_NUMA]; // posicao da thread entre as threads do seu no
+} jacobi_numa;
+
+int numa_setup(jacobi_numa *numa, jacobi_contexto *ctx);
+void numa_free(jacobi_numa *numa);
+void numa_report(const jacobi_numa *numa, FILE *arq);
+
+#endif
@@ -1,5 +1,5 @@
 // to compile: make par || make all
-// to execute: ./jacobipar <ordem_matriz> <seed> <threads> <line_for_verification>
+// to execute: ./jacobipar <ordem_matriz> <seed> <threads> <line_for_verification> [opcoes]
 /*
 Felipe Cecato - 12547785 
 Isaac Soares - 12751713
@@ -11,16 +11,31 @@ Pedro Oliveira Torrente - 11798853
 #include <stdio.h>
 #include <omp.h>
 #include <math.h>
+#include <string.h>
+#include <limits.h>
 
-#define MAX_ITERACOES 50000
-#define MAX_MATRIX_VALUE 1000
-#define PRECISAO_JACOBI 0.001
+#include "jacobipar.h"
+#include "jacobiperf.h"
+#include "jacobitrace.h"
+#include "jacobinuma.h"
+#include "jacobistream.h"
+#include "jacobiregen.h"
+#include "jacobickpt.h"
+#include "jacobicomp.h"
+#include "jacobisim.h"
+#include "jacobitune.h"
+#include "jacobiafin.h"
+#include "jacobiio.h"
+#include "jacobiserv.h"
 
-// Inicializa a matriz A e o vetor B com valores aleatorios
-void init_matrix(double *matrix, double *vet_b, int N)
+// Inicializa as linhas [i0, i1) da matriz A (em linhas, a partir da linha i0, com ld elementos e
+// preenchimento zerado) e os elementos de vet_b correspondentes com valores aleatorios. Chamada para
+// paineis consecutivos, consome rand() na mesma ordem que init_matrix
+void init_rows(double *linhas, double *vet_b, int i0, int i1, int N, int ld)
 {
-    for (int i = 0; i < N; i++)
+    for (int i = i0; i < i1; i++)
     {
+        double *linha = linhas + (size_t)(i - i0) * ld;
 
         // Soma a linha atual da matriz A
         double soma_linha = 0;
@@ -28,78 +43,260 @@ void init_matrix(double *matrix, double *vet_b, int N)
         // Gera uma linha da matriz A
         for (int j = 0; j < N; j++)
         {
-            matrix[i * N + j] = rand() % MAX_MATRIX_VALUE;
-            soma_linha += fabs(matrix[i * N + j]);
+            linha[j] = rand() % MAX_MATRIX_VALUE;
+            soma_linha += fabs(linha[j]);
         }
         // Verifica se a matriz eh diagonalmente dominante
-        if (fabs(matrix[i * N + i]) < soma_linha - fabs(matrix[i * N + i]))
+        if (fabs(linha[i]) < soma_linha - fabs(linha[i]))
         {                                       // Diagonal deve ser maior que a soma do modulo dos outros elementos da linha
-            matrix[i * N + i] = soma_linha + 1; // corrige a diagonal para ser maior que a soma do modulo dos outros elementos da linha
+            linha[i] = soma_linha + 1; // corrige a diagonal para ser maior que a soma do modulo dos outros elementos da linha
+        }
+
+        for (int j = N; j < ld; j++)
+        {
+            linha[j] = 0;
         }
 
         // Gera elemento do vetor B
-        vet_b[i] = rand() % 100;
+        vet_b[i - i0] = rand() % 100;
     }
 }
 
+// Inicializa a matriz A (linhas de ld elementos, preenchimento zerado) e o vetor B com valores aleatorios
+void init_matrix(double *matrix, double *vet_b, int N, int ld)
+{
+    init_rows(matrix, vet_b, 0, N, N, ld);
+}
+
 // Normaliza a matriz A e o vetor B e armazena a diagonal original da matriz A
-void normalize_matrix(double *matrix, double *vet_b, double *vet_diag, int N, int T)
+void normalize_matrix(double *matrix, double *vet_b, double *vet_diag, int N, int ld, int T)
 {
     int i, j = 0;
 
-#pragma omp parallel num_threads(T) shared(matrix, vet_b, vet_diag, N) private(i, j)
+#pragma omp parallel num_threads(T) shared(matrix, vet_b, vet_diag, N, ld) private(i, j)
     {
 #pragma omp single
         {
             for (i = 0; i < N; i++)
             {
-#pragma omp task depend(in : matrix[i * N + i])
+#pragma omp task depend(in : matrix[(size_t)i * ld + i])
                 {
-                    vet_b[i] = vet_b[i] / matrix[i * N + i];
-                    vet_diag[i] = matrix[i * N + i];
+                    vet_b[i] = vet_b[i] / matrix[(size_t)i * ld + i];
+                    vet_diag[i] = matrix[(size_t)i * ld + i];
                 }
-#pragma omp task depend(in : matrix[i * N + i])
+#pragma omp task depend(in : matrix[(size_t)i * ld + i])
                 for (j = 0; j < i; j++)
                 {
-                    matrix[i * N + j] = matrix[i * N + j] / matrix[i * N + i]; // normaliza cada linha em relacao ao elemento da diagonal
+                    matrix[(size_t)i * ld + j] = matrix[(size_t)i * ld + j] / matrix[(size_t)i * ld + i]; // normaliza cada linha em relacao ao elemento da diagonal
                 }
-#pragma omp task depend(in : matrix[i * N + i])
+#pragma omp task depend(in : matrix[(size_t)i * ld + i])
                 for (j = i + 1; j < N; j++)
                 {
-                    matrix[i * N + j] = matrix[i * N + j] / matrix[i * N + i]; // normaliza cada linha em relacao ao elemento da diagonal
+                    matrix[(size_t)i * ld + j] = matrix[(size_t)i * ld + j] / matrix[(size_t)i * ld + i]; // normaliza cada linha em relacao ao elemento da diagonal
                 }
-#pragma omp task depend(out : matrix[i * N + i])
+#pragma omp task depend(out : matrix[(size_t)i * ld + i])
                 {
-                    matrix[i * N + i] = 0; // zera a diagonal da matriz A
+                    matrix[(size_t)i * ld + i] = 0; // zera a diagonal da matriz A
                 }
             }
         }
     }
 }
 
-// Calculo do novo vetor X
-void calculate_new_x(double *matrix, double *vet_b, double *vet_x, double *vet_new_x, int N, int T)
+// Normaliza as linhas [i0, i1) (em linhas, a partir da linha i0) e os elementos de vet_b e vet_diag
+// correspondentes, com as mesmas divisoes de normalize_matrix. Usada na geracao por paineis
+void normalize_rows(double *linhas, double *vet_b, double *vet_diag, int i0, int i1, int ld, int T)
+{
+#pragma omp parallel for num_threads(T) schedule(static)
+    for (int i = i0; i < i1; i++)
+    {
+        double *linha = linhas + (size_t)(i - i0) * ld;
+        double diag = linha[i];
+        vet_b[i - i0] = vet_b[i - i0] / diag;
+        vet_diag[i - i0] = diag;
+        for (int j = 0; j < ld; j++)
+        {
+            linha[j] = linha[j] / diag;
+        }
+        linha[i] = 0; // zera a diagonal da matriz A
+    }
+}
+
+// Subtrai de soma[0..R) os produtos das linhas linhas[r * ld + j] pelo trecho [j0, j1) do vetor X. Com R
+// constante em cada chamada o laco em r eh desenrolado e cada x[j] carregado serve R linhas
+static inline void sweep_rows(const double *linhas, const double *vet_x, double *soma, const int R, int ld, int j0, int j1)
+{
+    double acc[MAX_BLOCO_LINHAS] = {0};
+#pragma omp simd reduction(+ : acc)
+    for (int j = j0; j < j1; j++)
+    {
+        for (int r = 0; r < R; r++)
+        {
+            acc[r] += linhas[(size_t)r * ld + j] * vet_x[j];
+        }
+    }
+    for (int r = 0; r < R; r++)
+    {
+        soma[r] -= acc[r];
+    }
+}
+
+// Calculo do novo vetor X. Na mesma varredura calcula o residuo do sistema original no vetor X
+// atual: (b - Ax)[i] = diag[i] * (B*[i] - x[i] - A*[i j].x[j]) = diag[i] * (novo_x[i] - x[i]).
+// residuo[0] recebe a norma infinito e residuo[1] a soma dos quadrados. kernel (NULL: padrao) escolhe o
+// agendamento do laco de linhas e a variante da varredura: KERNEL_LINHAS percorre uma linha por vez;
+// KERNEL_BLOCOS percorre bloco_linhas linhas juntas, em faixas de bloco_colunas colunas. No modo NUMA
+// (kernel->numa) as threads de cada no atualizam a replica de X do no e a varredura le somente dela. No
+// modo fora da memoria (kernel->fluxo) a matriz vem do disco, painel a painel (ver stream_new_x), e no
+// modo de regeneracao (kernel->gerador) as linhas sao recalculadas (ver regen_new_x). Com a matriz
+// comprimida (kernel->comprimida) a varredura le as mantissas (ver compressed_new_x) e com a matriz
+// simetrica (kernel->simetrica), somente o triangulo superior (ver symmetric_new_x)
+void calculate_new_x(double *matrix, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x, double *residuo,
+                     const jacobi_kernel *kernel, int N, int ld, int T)
 {
     int i, j = 0;
+    double res_max = 0;
+    double res_quad = 0;
+
+    jacobi_kernel padrao;
+    if (kernel == NULL)
+    {
+        jacobi_default_kernel(&padrao);
+        kernel = &padrao;
+    }
+    if (kernel->fluxo != NULL)
+    {
+        stream_new_x(kernel->fluxo, vet_b, vet_diag, vet_x, vet_new_x, residuo, N, T);
+        return;
+    }
+    if (kernel->gerador != NULL)
+    {
+        regen_new_x(kernel->gerador, vet_b, vet_diag, vet_x, vet_new_x, residuo, N, T);
+        return;
+    }
+    if (kernel->comprimida != NULL)
+    {
+        compressed_new_x(kernel->comprimida, vet_b, vet_diag, vet_x, vet_new_x, residuo, N, T);
+        return;
+    }
+    if (kernel->simetrica != NULL)
+    {
+        symmetric_new_x(kernel->simetrica, vet_b, vet_diag, vet_x, vet_new_x, residuo, N, T);
+        return;
+    }
+    omp_set_schedule(kernel->agendamento, kernel->chunk);
+
+    int R = kernel->variante == KERNEL_BLOCOS ? kernel->bloco_linhas : 1;
+    int faixa = kernel->bloco_colunas > 0 ? kernel->bloco_colunas : N;
+    int num_blocos = (N + R - 1) / R;
+    const jacobi_numa *numa = kernel->numa;
+
 // Atualiza o vetor X para a proxima iteracao
-#pragma omp parallel num_threads(T) shared(vet_new_x, matrix, vet_x, vet_b, N)
+#pragma omp parallel num_threads(T) shared(vet_new_x, matrix, vet_x, vet_b, vet_diag, N, ld, res_max, res_quad)
 {
-#pragma omp for simd private(i)
+    double local_max = 0; // reducoes locais da thread, combinadas ao final
+    double local_quad = 0;
+    const double *x_varredura = vet_x; // vetor X lido pela varredura
+
+    TRACE_INICIO(t_copia);
+#pragma omp for simd private(i) nowait
     for (i = 0; i < N; i++)
     {
         vet_x[i] = vet_new_x[i]; // vetor X recebe o novo vetor X (proximo chute)
-        vet_new_x[i] = vet_b[i]; // vetor novo X sempre comeca com B
     }
+    if (numa != NULL && omp_get_num_threads() == numa->T)
+    {
+        // As threads do no dividem a copia do novo X para a replica local
+        int t = omp_get_thread_num();
+        int no = numa->no_thread[t];
+        long i0 = (long)N * numa->posicao_thread[t] / numa->threads_no[no];
+        long i1 = (long)N * (numa->posicao_thread[t] + 1) / numa->threads_no[no];
+        memcpy(numa->vet_x_no[no] + i0, vet_new_x + i0, sizeof(double) * (i1 - i0));
+        x_varredura = numa->vet_x_no[no];
+    }
+    TRACE_FIM(TRACE_COPIA, t_copia);
 
-#pragma omp for simd private(i, j) reduction(+ : vet_new_x[ : N])
-    for (i = 0; i < N; i++)
+    // A varredura le todo o vetor X
+    TRACE_INICIO(t_barreira);
+#pragma omp barrier
+    TRACE_FIM(TRACE_BARREIRA, t_barreira);
+
+    TRACE_INICIO(t_varredura);
+    if (kernel->variante == KERNEL_LINHAS)
+    {
+#pragma omp for private(i, j) schedule(runtime) nowait
+        for (i = 0; i < N; i++)
+        {
+            double soma = vet_b[i]; // vetor novo X sempre comeca com B
+#pragma omp simd reduction(+ : soma)
+            for (j = 0; j < N; j++)
+            {
+                soma -= matrix[(size_t)i * ld + j] * x_varredura[j];
+            }
+            vet_new_x[i] = soma;
+
+            double r = vet_diag[i] * (soma - vet_x[i]);
+            local_max = fmax(local_max, fabs(r));
+            local_quad += r * r;
+        }
+    }
+    else
     {
-        for (j = 0; j < N; j++)
+#pragma omp for schedule(runtime) nowait
+        for (int g = 0; g < num_blocos; g++)
         {
-            vet_new_x[i] -= matrix[i * N + j] * vet_x[j];
+            int i0 = g * R;
+            int linhas = i0 + R <= N ? R : N - i0;
+            const double *bloco = matrix + (size_t)i0 * ld;
+            double soma[MAX_BLOCO_LINHAS];
+
+            for (int r = 0; r < linhas; r++)
+            {
+                soma[r] = vet_b[i0 + r]; // vetor novo X sempre comeca com B
+            }
+            for (int j0 = 0; j0 < N; j0 += faixa)
+            {
+                int j1 = j0 + faixa < N ? j0 + faixa : N;
+                switch (linhas)
+                {
+                case 8:
+                    sweep_rows(bloco, x_varredura, soma, 8, ld, j0, j1);
+                    break;
+                case 4:
+                    sweep_rows(bloco, x_varredura, soma, 4, ld, j0, j1);
+                    break;
+                case 2:
+                    sweep_rows(bloco, x_varredura, soma, 2, ld, j0, j1);
+                    break;
+                default: // ultimo bloco incompleto
+                    for (int r = 0; r < linhas; r++)
+                    {
+                        sweep_rows(bloco + (size_t)r * ld, x_varredura, soma + r, 1, ld, j0, j1);
+                    }
+                }
+            }
+            for (int r = 0; r < linhas; r++)
+            {
+                vet_new_x[i0 + r] = soma[r];
+
+                double res = vet_diag[i0 + r] * (soma[r] - vet_x[i0 + r]);
+                local_max = fmax(local_max, fabs(res));
+                local_quad += res * res;
+            }
         }
     }
+    TRACE_FIM(TRACE_VARREDURA, t_varredura);
+
+    TRACE_INICIO(t_reducao);
+#pragma omp critical
+    {
+        res_max = fmax(res_max, local_max);
+        res_quad += local_quad;
+    }
+    TRACE_FIM(TRACE_REDUCAO, t_reducao);
 }
+    residuo[0] = res_max;
+    residuo[1] = res_quad;
 }
 
 // Calculo do erro (criterio de parada)
@@ -107,120 +304,1612 @@ void calculate_error(double *vet_x, double *vet_new_x, double *error, int N, int
 {
     double max_diff = 0;
     double max_new_x = fabs(vet_new_x[0]);
-    double *diff = (double *)malloc(sizeof(double) * N);
-    if (diff == NULL)
+
+#pragma omp parallel num_threads(T) shared(vet_x, vet_new_x, N, max_diff, max_new_x)
+{
+    double local_diff = 0; // maiores valores do trecho da thread
+    double local_new_x = 0;
+
+    TRACE_INICIO(t_erro);
+#pragma omp for nowait
+    for (int i = 0; i < N; i++)
+    {
+        double diff = fabs(vet_new_x[i] - vet_x[i]); // calcula diferenca entre o novo vetor X e o vetor X
+        if (diff > local_diff)
+        {
+            local_diff = diff; // calcula o maior valor da diferenca
+        }
+
+        if (fabs(vet_new_x[i]) > local_new_x)
+        {
+            local_new_x = fabs(vet_new_x[i]); // calcula o maior valor do novo vetor X
+        }
+    }
+    TRACE_FIM(TRACE_ERRO, t_erro);
+
+    TRACE_INICIO(t_reducao);
+#pragma omp critical
+    {
+        max_diff = fmax(max_diff, local_diff);
+        max_new_x = fmax(max_new_x, local_new_x);
+    }
+    TRACE_FIM(TRACE_REDUCAO, t_reducao);
+}
+
+    *error = max_diff / max_new_x;
+}
+
+// Aloca o estado da aceleracao de Anderson com historico de profundidade m
+void anderson_init(jacobi_anderson *anderson, int m, int N)
+{
+    anderson->m = m;
+    anderson->k = 0;
+    anderson->df = (double *)alloc_aligned(sizeof(double) * m * N);
+    anderson->dg = (double *)alloc_aligned(sizeof(double) * m * N);
+    anderson->f_ant = (double *)alloc_aligned(sizeof(double) * N);
+    anderson->g_ant = (double *)alloc_aligned(sizeof(double) * N);
+    anderson->gram = (double *)alloc_aligned(sizeof(double) * m * m);
+    anderson->rhs = (double *)alloc_aligned(sizeof(double) * m);
+    anderson->gamma = (double *)alloc_aligned(sizeof(double) * m);
+    if (anderson->df == NULL || anderson->dg == NULL || anderson->f_ant == NULL || anderson->g_ant == NULL ||
+        anderson->gram == NULL || anderson->rhs == NULL || anderson->gamma == NULL)
     {
         printf("Erro de alocação de memória\n");
         exit(1);
     }
+}
+
+void anderson_free(jacobi_anderson *anderson)
+{
+    free_aligned(anderson->df);
+    free_aligned(anderson->dg);
+    free_aligned(anderson->f_ant);
+    free_aligned(anderson->g_ant);
+    free_aligned(anderson->gram);
+    free_aligned(anderson->rhs);
+    free_aligned(anderson->gamma);
+}
+
+// Resolve o sistema (gram + lambda.I) gamma = rhs de ordem n por eliminacao de Gauss com pivoteamento
+// parcial. Retorna 0 se o sistema for singular
+int solve_small_system(double *gram, double *rhs, double *gamma, int n, int ld)
+{
+    double a[MAX_ANDERSON * MAX_ANDERSON];
+    double traco = 0;
+
+    for (int i = 0; i < n; i++)
+    {
+        traco += gram[i * ld + i];
+    }
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            a[i * n + j] = gram[i * ld + j];
+        }
+        a[i * n + i] += REGULARIZACAO_ANDERSON * traco; // regularizacao de Tikhonov: historico quase colinear
+        gamma[i] = rhs[i];
+    }
+
+    for (int c = 0; c < n; c++)
+    {
+        int pivo = c;
+        for (int i = c + 1; i < n; i++)
+        {
+            if (fabs(a[i * n + c]) > fabs(a[pivo * n + c]))
+            {
+                pivo = i;
+            }
+        }
+        if (fabs(a[pivo * n + c]) <= 0 || !isfinite(a[pivo * n + c]))
+        {
+            return 0;
+        }
+        if (pivo != c)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                double tmp = a[c * n + j];
+                a[c * n + j] = a[pivo * n + j];
+                a[pivo * n + j] = tmp;
+            }
+            double tmp = gamma[c];
+            gamma[c] = gamma[pivo];
+            gamma[pivo] = tmp;
+        }
+        for (int i = c + 1; i < n; i++)
+        {
+            double fator = a[i * n + c] / a[c * n + c];
+            for (int j = c; j < n; j++)
+            {
+                a[i * n + j] -= fator * a[c * n + j];
+            }
+            gamma[i] -= fator * gamma[c];
+        }
+    }
+
+    for (int i = n - 1; i >= 0; i--)
+    {
+        for (int j = i + 1; j < n; j++)
+        {
+            gamma[i] -= a[i * n + j] * gamma[j];
+        }
+        gamma[i] /= a[i * n + i];
+    }
+
+    return 1;
+}
+
+// Aceleracao de Anderson: recebe x(k) em vet_x e g(x(k)) em vet_new_x (saida de calculate_new_x) e
+// substitui vet_new_x pela combinacao x(k+1) = g(x(k)) - sum(gamma[a] * dg[a]), onde gamma minimiza
+// |f(k) - sum(gamma[a] * df[a])|. Somente a coluna nova da matriz de Gram eh recalculada: O(mN) por iteracao
+void anderson_mix(jacobi_anderson *anderson, double *vet_x, double *vet_new_x, int N, int T)
+{
+    int m = anderson->m;
+    int k = anderson->k;
+    double *df = anderson->df;
+    double *dg = anderson->dg;
+    double *f_ant = anderson->f_ant;
+    double *g_ant = anderson->g_ant;
+
+    if (k == 0)
+    {
+#pragma omp parallel for simd num_threads(T)
+        for (int i = 0; i < N; i++)
+        {
+            f_ant[i] = vet_new_x[i] - vet_x[i];
+            g_ant[i] = vet_new_x[i];
+        }
+        anderson->k = 1;
+        return;
+    }
 
-#pragma omp parallel for simd num_threads(T) firstprivate(diff, vet_x, vet_new_x, N) reduction(max : max_diff, max_new_x)
+    int col = (k - 1) % m;         // coluna do historico substituida nesta iteracao
+    int mk = k < m ? k : m;        // colunas validas no historico
+    double prod[2 * MAX_ANDERSON]; // [0, m): df[a] . df[col]; [m, 2m): df[a] . f(k)
+    memset(prod, 0, sizeof(prod));
+    double *df_col = df + (size_t)col * N;
+    double *dg_col = dg + (size_t)col * N;
+
+#pragma omp parallel for num_threads(T) reduction(+ : prod[ : 2 * MAX_ANDERSON])
     for (int i = 0; i < N; i++)
     {
-        diff[i] = fabs(vet_new_x[i] - vet_x[i]); // calcula diferenca entre o novo vetor X e o vetor X
-        if (diff[i] > max_diff)
+        double f = vet_new_x[i] - vet_x[i];
+        df_col[i] = f - f_ant[i];
+        dg_col[i] = vet_new_x[i] - g_ant[i];
+        f_ant[i] = f;
+        g_ant[i] = vet_new_x[i];
+        for (int a = 0; a < mk; a++)
         {
-            max_diff = diff[i]; // calcula o maior valor da diferenca
+            prod[a] += df[(size_t)a * N + i] * df_col[i];
+            prod[MAX_ANDERSON + a] += df[(size_t)a * N + i] * f;
         }
+    }
 
-        if (fabs(vet_new_x[i]) > max_new_x)
+    for (int a = 0; a < mk; a++)
+    {
+        anderson->gram[a * m + col] = prod[a];
+        anderson->gram[col * m + a] = prod[a];
+        anderson->rhs[a] = prod[MAX_ANDERSON + a];
+    }
+    anderson->k = k + 1;
+
+    if (!solve_small_system(anderson->gram, anderson->rhs, anderson->gamma, mk, m))
+    {
+        anderson->k = 0; // historico degenerado: reinicia e usa o passo de Jacobi puro
+        return;
+    }
+
+    double *gamma = anderson->gamma;
+#pragma omp parallel for num_threads(T)
+    for (int i = 0; i < N; i++)
+    {
+        double soma = 0;
+        for (int a = 0; a < mk; a++)
         {
-            max_new_x = fabs(vet_new_x[i]); // calcula o maior valor do novo vetor X
+            soma += gamma[a] * dg[(size_t)a * N + i];
         }
+        vet_new_x[i] -= soma;
     }
+}
 
-    *error = max_diff / max_new_x;
-    free(diff);
+// Estima o fator de contracao assintotico (razao media entre erros consecutivos) a partir dos
+// ultimos JANELA_PREDITOR erros guardados no buffer circular hist_erro. Retorna -1 se a taxa
+// ainda nao se estabilizou (razao media da primeira e da segunda metade da janela muito diferentes)
+double estimate_contraction(double *hist_erro, int cont)
+{
+    int meio = JANELA_PREDITOR / 2;
+    double e_ini = hist_erro[cont % JANELA_PREDITOR]; // erro mais antigo da janela
+    double e_meio = hist_erro[(cont + meio) % JANELA_PREDITOR];
+    double e_fim = hist_erro[(cont + JANELA_PREDITOR - 1) % JANELA_PREDITOR]; // erro mais recente
+
+    if (e_ini <= 0 || e_meio <= 0 || e_fim <= 0)
+    {
+        return -1;
+    }
+
+    double taxa_1 = pow(e_meio / e_ini, 1.0 / meio);
+    double taxa_2 = pow(e_fim / e_meio, 1.0 / (JANELA_PREDITOR - 1 - meio));
+    if (fabs(taxa_2 - taxa_1) > ESTABILIDADE_TAXA * taxa_2)
+    {
+        return -1;
+    }
+
+    return taxa_2;
 }
 
-int main(int argc, char **argv)
+// Preditor de convergencia: com base na taxa de contracao estimada, decide se o laco pode parar
+// antes do criterio de parada (erro extrapolado ja abaixo da tolerancia) ou se deve ser abortado
+// (numero de iteracoes previsto excede max_iteracoes). error eh o criterio de parada normalizado
+// pela tolerancia (converge quando error <= 1). A parada antecipada so vale com antecipar: a estimativa
+// a posteriori limita o erro do iterado, nao o residuo. Retorna -1 se nao ha decisao a tomar
+int predict_convergence(double *hist_erro, int cont, double error, int max_iteracoes, int antecipar, int *previstas)
 {
-    // Argumentos de entrada
-    if (argc != 5)
+    if (cont < JANELA_PREDITOR)
     {
-        printf("Wrong arguments. Please use main <ordem_matriz> <seed> <num_threads> <line_for_verification>\n");
-        exit(0);
+        return -1;
     }
 
-    int N = atoi(argv[1]);
-    int seed = atoi(argv[2]);
-    int T = atoi(argv[3]);
-    int linha = atoi(argv[4]);
+    double taxa = estimate_contraction(hist_erro, cont);
+    if (taxa < 0)
+    {
+        return -1;
+    }
+    if (taxa >= 1)
+    {
+        *previstas = -1;
+        return JACOBI_NAO_CONVERGE; // erro nao diminui: o sistema nunca vai convergir
+    }
+
+    // Estimativa a posteriori do erro real: |x* - x(k)| <= taxa / (1 - taxa) * |x(k) - x(k-1)|
+    if (antecipar && error * taxa / (1 - taxa) <= 1)
+    {
+        *previstas = cont;
+        return JACOBI_CONVERGENCIA_PREVISTA;
+    }
 
-    // Alocacao de memoria para matriz A e vetor B
-    double *matrix = (double *)malloc(sizeof(double *) * N * N);
-    double *vet_b = (double *)malloc(sizeof(double) * N);
-    double *vet_diag = (double *)malloc(sizeof(double) * N); // Vetor que armazena a diagonal original da matriz A para posterior substituicao na equacao
-    if (matrix == NULL || vet_b == NULL || vet_diag == NULL)
+    // Iteracoes restantes para que error * taxa^k <= 1
+    double restantes = ceil(log(1 / error) / log(taxa));
+    if (cont + restantes > max_iteracoes)
+    {
+        *previstas = (int)fmin(cont + restantes, INT_MAX);
+        return JACOBI_NAO_CONVERGE;
+    }
+
+    return -1;
+}
+
+// Opcoes padrao do solver: criterio de variacao relativa com PRECISAO_JACOBI, ate MAX_ITERACOES iteracoes
+void jacobi_default_options(jacobi_opcoes *opcoes)
+{
+    opcoes->preditor = 0;
+    opcoes->anderson = 0;
+    opcoes->criterio = CRITERIO_VARIACAO;
+    opcoes->tol = PRECISAO_JACOBI;
+    opcoes->atol = 0;
+    opcoes->max_iteracoes = MAX_ITERACOES;
+    opcoes->iteracao_inicial = 0;
+    opcoes->checkpoint = NULL;
+}
+
+// Kernel padrao: uma linha por vez, agendamento estatico em blocos contiguos de linhas
+void jacobi_default_kernel(jacobi_kernel *kernel)
+{
+    kernel->variante = KERNEL_LINHAS;
+    kernel->bloco_linhas = 1;
+    kernel->bloco_colunas = 0;
+    kernel->agendamento = omp_sched_static;
+    kernel->chunk = 0;
+    kernel->numa = NULL;
+    kernel->fluxo = NULL;
+    kernel->gerador = NULL;
+    kernel->comprimida = NULL;
+    kernel->simetrica = NULL;
+}
+
+// Aloca o contexto de um sistema de ordem N resolvido com T threads (matriz em paginas enormes
+// transparentes)
+void jacobi_init(jacobi_contexto *ctx, int N, int T)
+{
+    jacobi_init_pages(ctx, N, T, PAGINAS_THP);
+}
+
+// Como jacobi_init, com a matriz no tipo de pagina pedido (PAGINAS_*) ou no maior disponivel abaixo dele.
+// Os vetores ficam alinhados em ALINHAMENTO bytes e as linhas da matriz a cada ctx->ld elementos. Com
+// PAGINAS_ARQUIVO a matriz nao eh alocada: jacobi_load a mapeia do arquivo normalizado; com
+// PAGINAS_SEM_MATRIZ ela nunca existe (regen_init)
+void jacobi_init_pages(jacobi_contexto *ctx, int N, int T, int paginas)
+{
+    ctx->N = N;
+    ctx->T = T;
+    ctx->cont = 0;
+    ctx->error = 1;
+    ctx->residuo_inf = 0;
+    ctx->residuo_2 = 0;
+    ctx->previstas = 0;
+    ctx->tempo_iteracoes = 0;
+    jacobi_default_kernel(&ctx->kernel);
+
+    // Alocacao de memoria para matriz A e vetores
+    ctx->ld = leading_dimension(N);
+    ctx->paginas = paginas;
+    ctx->bytes_matriz = 0;
+    int alocar = paginas != PAGINAS_ARQUIVO && paginas != PAGINAS_SEM_MATRIZ;
+    ctx->matrix = alocar ? alloc_matrix(sizeof(double) * N * ctx->ld, paginas, &ctx->paginas, &ctx->bytes_matriz) : NULL;
+    ctx->vet_b = (double *)alloc_aligned(sizeof(double) * N);
+    ctx->vet_diag = (double *)alloc_aligned(sizeof(double) * N); // Vetor que armazena a diagonal original da matriz A para posterior substituicao na equacao
+    ctx->vet_x = (double *)alloc_aligned(sizeof(double) * N);
+    ctx->vet_new_x = (double *)alloc_aligned(sizeof(double) * N);
+    if ((ctx->matrix == NULL && alocar) || ctx->vet_b == NULL || ctx->vet_diag == NULL ||
+        ctx->vet_x == NULL || ctx->vet_new_x == NULL)
     {
         printf("Erro de alocação de memória\n");
         exit(1);
     }
+}
+
+void jacobi_free(jacobi_contexto *ctx)
+{
+    free_matrix(ctx->matrix, ctx->paginas, ctx->bytes_matriz);
+    free_aligned(ctx->vet_b);
+    free_aligned(ctx->vet_diag);
+    free_aligned(ctx->vet_x);
+    free_aligned(ctx->vet_new_x);
+}
 
+// Gera um sistema aleatorio diagonalmente dominante, normaliza e usa o vetor B como chute inicial
+void jacobi_generate(jacobi_contexto *ctx, int seed)
+{
     // Define a semente para geracao de numeros aleatorios
     srand(seed);
 
     // Inicializa a matriz A e o vetor B com valores aleatorios
-    init_matrix(matrix, vet_b, N);
+    PERF_INICIO(PERF_INIT_MATRIX);
+    init_matrix(ctx->matrix, ctx->vet_b, ctx->N, ctx->ld);
+    PERF_FIM(PERF_INIT_MATRIX);
 
     // Normaliza a matriz A e o vetor B e armazena a diagonal original da matriz A
-    normalize_matrix(matrix, vet_b, vet_diag, N, T);
+    PERF_INICIO(PERF_NORMALIZE_MATRIX);
+    normalize_matrix(ctx->matrix, ctx->vet_b, ctx->vet_diag, ctx->N, ctx->ld, ctx->T);
+    PERF_FIM(PERF_NORMALIZE_MATRIX);
+
+    jacobi_set_initial_guess(ctx, ctx->vet_b);
+}
+
+// Define o chute inicial da proxima resolucao (warm start)
+void jacobi_set_initial_guess(jacobi_contexto *ctx, const double *vet_x0)
+{
+    double *vet_x = ctx->vet_x;
+    double *vet_new_x = ctx->vet_new_x;
+
+#pragma omp parallel for simd num_threads(ctx->T)
+    for (int i = 0; i < ctx->N; i++)
+    {
+        vet_x[i] = vet_x0[i];
+        vet_new_x[i] = vet_x0[i];
+    }
+}
+
+// Resolucao incremental: substitui k elementos do vetor B original (sem normalizacao) mantendo a
+// matriz normalizada e a solucao atual como chute inicial
+void jacobi_update_b(jacobi_contexto *ctx, const int *indices, const double *valores, int k)
+{
+    for (int c = 0; c < k; c++)
+    {
+        int i = indices[c];
+        ctx->vet_b[i] = valores[c] / ctx->vet_diag[i];
+    }
+}
+
+// Resolucao incremental: substitui k linhas da matriz A original (valores contem k linhas de N
+// elementos, sem normalizacao). Somente essas linhas sao renormalizadas; o vetor B original eh
+// preservado e reescalado pela nova diagonal. Retorna 0, sem alterar o sistema, se alguma linha esta
+// fora da matriz, repetida ou com diagonal nula, ou se a varredura nao le ctx->matrix (fora da memoria,
+// regenerada, comprimida ou simetrica), caso em que a representacao derivada ficaria desatualizada
+int jacobi_update_rows(jacobi_contexto *ctx, const int *linhas, const double *valores, int k)
+{
+    int N = ctx->N;
+    int ld = ctx->ld;
+    double *matrix = ctx->matrix;
+    double *vet_b = ctx->vet_b;
+    double *vet_diag = ctx->vet_diag;
 
-    double *vet_x = (double *)malloc(sizeof(double) * N);
-    double *vet_new_x = (double *)malloc(sizeof(double) * N);
-    if (vet_x == NULL || vet_new_x == NULL)
+    if (matrix == NULL || ctx->kernel.fluxo != NULL || ctx->kernel.gerador != NULL || ctx->kernel.comprimida != NULL ||
+        ctx->kernel.simetrica != NULL)
+    {
+        return 0;
+    }
+
+    // Valida todas as linhas antes de alterar qualquer uma
+    char *marcada = (char *)calloc(N, 1);
+    if (marcada == NULL)
     {
         printf("Erro de alocação de memória\n");
         exit(1);
     }
+    int ok = 1;
+    for (int c = 0; c < k && ok; c++)
+    {
+        int i = linhas[c];
+        ok = i >= 0 && i < N && !marcada[i] && valores[(size_t)c * N + i] != 0 && isfinite(valores[(size_t)c * N + i]);
+        if (ok)
+        {
+            marcada[i] = 1;
+        }
+    }
+    free(marcada);
+    if (!ok)
+    {
+        return 0;
+    }
 
-    // Inicializacao dos vetores X e novo X
-    for (int i = 0; i < N; i++)
+    // Linhas distintas: cada iteracao escreve somente a sua linha
+#pragma omp parallel for num_threads(ctx->T)
+    for (int c = 0; c < k; c++)
     {
-        vet_x[i] = vet_b[i];
-        vet_new_x[i] = vet_x[i];
+        int i = linhas[c];
+        const double *linha = valores + (size_t)c * N;
+        double diag = linha[i];
+
+        vet_b[i] = vet_b[i] * vet_diag[i] / diag; // B original da linha, normalizado pela nova diagonal
+        vet_diag[i] = diag;
+        for (int j = 0; j < N; j++)
+        {
+            matrix[(size_t)i * ld + j] = linha[j] / diag; // normaliza a linha em relacao ao elemento da diagonal
+        }
+        matrix[(size_t)i * ld + i] = 0; // zera a diagonal da matriz A
     }
+    return 1;
+}
 
-    int cont = 0;
-    double error = 1;
+// Verifica a solucao atual (vet_x) calculando o residuo r = b - Ax de todas as linhas do sistema
+// original, em paralelo e sem alterar a matriz normalizada: r[i] = diag[i] * (B*[i] - x[i] - A*[i j].x[j]).
+// vet_r (opcional, pode ser NULL) recebe o vetor residuo. Com a matriz comprimida, a matriz densa eh
+// usada enquanto ctx->matrix existir; sem ela, o residuo eh o do sistema comprimido
+void jacobi_verify(jacobi_contexto *ctx, double *vet_r, jacobi_verificacao *verificacao)
+{
+    int N = ctx->N;
+    int ld = ctx->ld;
+    double *matrix = ctx->matrix;
+    double *vet_b = ctx->vet_b;
+    double *vet_diag = ctx->vet_diag;
+    double *vet_x = ctx->vet_x;
+
+    double res_max = -1;
+    int linha_max = 0;
+    double res_quad = 0;
+    double b_max = 0;
 
-    while (error > PRECISAO_JACOBI && cont < MAX_ITERACOES)
+    // Fora da memoria, com a matriz regenerada, comprimida (e a densa ja liberada) ou simetrica: uma
+    // varredura calcula B* - A*.x de todas as linhas antes do laco
+    double *vet_soma = NULL;
+    if (ctx->kernel.fluxo != NULL || ctx->kernel.gerador != NULL ||
+        (ctx->kernel.comprimida != NULL && matrix == NULL) || ctx->kernel.simetrica != NULL)
     {
-        // Calculo do novo vetor X  -> x[i]k+1 = B*[i] - (A*[i j].x[j]k), para i <> j e 0 >= j < n
-        calculate_new_x(matrix, vet_b, vet_x, vet_new_x, N, T);
-        // Calculo do erro (criterio de parada)
-        calculate_error(vet_x, vet_new_x, &error, N, T);
-        cont++;
+        vet_soma = (double *)alloc_aligned(sizeof(double) * N);
+        if (vet_soma == NULL)
+        {
+            printf("Erro de alocação de memória\n");
+            exit(1);
+        }
+        if (ctx->kernel.fluxo != NULL)
+        {
+            stream_sweep(ctx->kernel.fluxo, vet_b, vet_x, vet_soma, ctx->T);
+        }
+        else if (ctx->kernel.gerador != NULL)
+        {
+            regen_sweep(ctx->kernel.gerador, vet_b, vet_diag, vet_x, vet_soma, ctx->T);
+        }
+        else if (ctx->kernel.comprimida != NULL)
+        {
+            compressed_sweep(ctx->kernel.comprimida, vet_b, vet_x, vet_soma, ctx->T);
+        }
+        else
+        {
+            symmetric_sweep(ctx->kernel.simetrica, vet_b, vet_diag, vet_x, vet_soma);
+        }
     }
 
-    double result = 0;
-    if (linha >= 0 && linha < N)
+#pragma omp parallel num_threads(ctx->T) shared(matrix, vet_b, vet_diag, vet_x, vet_r, vet_soma, N, ld)
     {
-#pragma omp parallel for num_threads(T) shared(matrix, vet_diag, vet_x, N) reduction(+ : result)
+        double local_max = -1; // maior residuo (e sua linha) das linhas desta thread
+        int local_linha = 0;
+
+#pragma omp for reduction(+ : res_quad) reduction(max : b_max)
         for (int i = 0; i < N; i++)
         {
-            // Reconstroi a linha original da matriz A (sem normalizacao)
-            if (i != linha)
+            double soma = vet_b[i] - vet_x[i];
+            if (vet_soma != NULL)
             {
-                matrix[linha * N + i] *= vet_diag[linha];
+                soma = vet_soma[i] - vet_x[i];
             }
             else
             {
-                matrix[linha * N + i] = vet_diag[linha];
+#pragma omp simd reduction(+ : soma)
+                for (int j = 0; j < N; j++)
+                {
+                    soma -= matrix[(size_t)i * ld + j] * vet_x[j];
+                }
+            }
+
+            double r = vet_diag[i] * soma;
+            if (vet_r != NULL)
+            {
+                vet_r[i] = r;
+            }
+            if (fabs(r) > local_max)
+            {
+                local_max = fabs(r);
+                local_linha = i;
             }
-            // Avalia equacao com o valor do vetor X
-            result += matrix[linha * N + i] * vet_x[i];
+            res_quad += r * r;
+            b_max = fmax(b_max, fabs(vet_b[i] * vet_diag[i]));
         }
-        // printf("Valor esperado: %f\n", vet_b[linha] * vet_diag[linha]);
-        // printf("Resultado da atribuicao na linha %d (%d iteracoes): %.6f\n", linha, cont, result);
-        // printf("Erro: %.6f\n", error);
-    }
 
-    free(matrix);
-    free(vet_b);
-    free(vet_diag);
-    free(vet_x);
-    free(vet_new_x);
+#pragma omp critical
+        if (local_max > res_max || (local_max == res_max && local_linha < linha_max))
+        {
+            res_max = local_max;
+            linha_max = local_linha;
+        }
+    }
 
-    return 0;
+    free_aligned(vet_soma);
+    verificacao->residuo_max = res_max;
+    verificacao->linha_max = linha_max;
+    verificacao->residuo_2 = sqrt(res_quad);
+    verificacao->residuo_relativo = b_max > 0 ? res_max / b_max : res_max;
 }
+
+// Itera a partir do chute atual ate satisfazer o criterio de parada. Ao final, vet_x e vet_new_x
+// contem a solucao, de modo que uma nova chamada continua (warm start) a partir dela. A contagem de
+// iteracoes comeca em opcoes->iteracao_inicial (retomada de checkpoint)
+int jacobi_solve(jacobi_contexto *ctx, const jacobi_opcoes *opcoes)
+{
+    int N = ctx->N;
+    int T = ctx->T;
+    double *vet_x = ctx->vet_x;
+    double *vet_new_x = ctx->vet_new_x;
+
+    int cont = opcoes->iteracao_inicial;
+    double error = 1;
+    double residuo[2] = {0, 0};
+    double hist_erro[JANELA_PREDITOR] = {0}; // ultimas medidas de convergencia, para o preditor (zero: ainda sem medida)
+    int status = JACOBI_MAX_ITERACOES;
+    int previstas = 0;
+
+    // Limites dos criterios de residuo: |b - Ax| <= max(atol, tol * |b|), na norma escolhida
+    double norma_b_max = 0;
+    double norma_b_quad = 0;
+#pragma omp parallel for num_threads(T) reduction(max : norma_b_max) reduction(+ : norma_b_quad)
+    for (int i = 0; i < N; i++)
+    {
+        double b = ctx->vet_b[i] * ctx->vet_diag[i]; // B original
+        norma_b_max = fmax(norma_b_max, fabs(b));
+        norma_b_quad += b * b;
+    }
+    double limite_inf = fmax(opcoes->atol, opcoes->tol * norma_b_max);
+    double limite_2 = fmax(opcoes->atol, opcoes->tol * sqrt(norma_b_quad));
+
+    jacobi_anderson anderson;
+    if (opcoes->anderson > 0)
+    {
+        anderson_init(&anderson, opcoes->anderson, N);
+    }
+
+    double inicio = omp_get_wtime();
+    while (cont < opcoes->max_iteracoes)
+    {
+        trace_iteracao = cont;
+        TRACE_INICIO(t_iteracao);
+        // Calculo do novo vetor X  -> x[i]k+1 = B*[i] - (A*[i j].x[j]k), para i <> j e 0 >= j < n
+        PERF_INICIO(PERF_CALCULATE_NEW_X);
+        calculate_new_x(ctx->matrix, ctx->vet_b, ctx->vet_diag, vet_x, vet_new_x, residuo, &ctx->kernel, N, ctx->ld, T);
+        PERF_FIM(PERF_CALCULATE_NEW_X);
+        if (opcoes->anderson > 0)
+        {
+            anderson_mix(&anderson, vet_x, vet_new_x, N, T);
+        }
+        // Calculo do erro (criterio de parada)
+        PERF_INICIO(PERF_CALCULATE_ERROR);
+        calculate_error(vet_x, vet_new_x, &error, N, T);
+        PERF_FIM(PERF_CALCULATE_ERROR);
+        TRACE_FIM(TRACE_ITERACAO, t_iteracao);
+        cont++;
+
+        // Medida de convergencia: maior razao entre cada criterio escolhido e seu limite. O
+        // sistema converge quando todos os criterios estao satisfeitos (medida <= 1)
+        double medida = 0;
+        if (opcoes->criterio & CRITERIO_VARIACAO)
+        {
+            medida = fmax(medida, error / opcoes->tol);
+        }
+        if (opcoes->criterio & CRITERIO_RESIDUO_INF)
+        {
+            medida = fmax(medida, limite_inf > 0 ? residuo[0] / limite_inf : 0);
+        }
+        if (opcoes->criterio & CRITERIO_RESIDUO_2)
+        {
+            medida = fmax(medida, limite_2 > 0 ? sqrt(residuo[1]) / limite_2 : 0);
+        }
+        hist_erro[(cont - 1) % JANELA_PREDITOR] = medida;
+
+        if (medida <= 1)
+        {
+            status = JACOBI_CONVERGIU;
+            break;
+        }
+
+        if (opcoes->checkpoint != NULL)
+        {
+            checkpoint_tick(opcoes->checkpoint, vet_new_x, cont, error);
+        }
+
+        if (opcoes->preditor)
+        {
+            // Com criterios de residuo ativos o preditor so aborta
+            int antecipar = opcoes->criterio == CRITERIO_VARIACAO;
+            int decisao = predict_convergence(hist_erro, cont, medida, opcoes->max_iteracoes, antecipar, &previstas);
+            if (decisao >= 0)
+            {
+                status = decisao;
+                break;
+            }
+        }
+    }
+
+    if (opcoes->anderson > 0)
+    {
+        anderson_free(&anderson);
+    }
+
+    // A solucao eh o ultimo vetor calculado
+    memcpy(vet_x, vet_new_x, sizeof(double) * N);
+
+    ctx->tempo_iteracoes = omp_get_wtime() - inicio;
+    ctx->cont = cont;
+    ctx->error = error;
+    ctx->residuo_inf = residuo[0];
+    ctx->residuo_2 = sqrt(residuo[1]);
+    ctx->previstas = previstas;
+    return status;
+}
+
+// Banda de memoria sustentada (GB/s) medida com o kernel triad do STREAM (a = b + s.c) com T threads,
+// melhor de REPETICOES_STREAM execucoes. Conta 24 bytes por elemento (sem write-allocate), como o STREAM
+double measure_stream_bandwidth(int T)
+{
+    long n = TAMANHO_STREAM;
+    double *a = (double *)alloc_aligned(sizeof(double) * n);
+    double *b = (double *)alloc_aligned(sizeof(double) * n);
+    double *c = (double *)alloc_aligned(sizeof(double) * n);
+    if (a == NULL || b == NULL || c == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+
+    // Primeiro toque em paralelo, com a mesma distribuicao do kernel
+#pragma omp parallel for simd num_threads(T) schedule(static)
+    for (long i = 0; i < n; i++)
+    {
+        a[i] = 0;
+        b[i] = 1;
+        c[i] = 2;
+    }
+
+    double melhor = 1e30;
+    for (int r = 0; r < REPETICOES_STREAM; r++)
+    {
+        double t0 = omp_get_wtime();
+#pragma omp parallel for simd num_threads(T) schedule(static)
+        for (long i = 0; i < n; i++)
+        {
+            a[i] = b[i] + 3.0 * c[i];
+        }
+        double t = omp_get_wtime() - t0;
+        if (t < melhor)
+        {
+            melhor = t;
+        }
+    }
+
+    free_aligned(a);
+    free_aligned(b);
+    free_aligned(c);
+    return 3.0 * sizeof(double) * n / melhor / 1e9;
+}
+
+// Desempenho do laco de iteracoes da ultima resolucao (GFLOP/s e GB/s efetivos), comparado com a banda
+// sustentada banda_pico (GB/s). Por iteracao: a varredura le a matriz (8N^2 bytes, 2N^2 flops) e os
+// vetores sao lidos/escritos poucas vezes (~72N bytes, ~8N flops em calculate_new_x e calculate_error)
+void jacobi_performance(jacobi_contexto *ctx, double banda_pico, jacobi_desempenho *desempenho)
+{
+    double N = ctx->N;
+    double tempo_iteracao = ctx->cont > 0 ? ctx->tempo_iteracoes / ctx->cont : 0;
+
+    desempenho->tempo_iteracao = tempo_iteracao;
+    desempenho->flops_iteracao = 2 * N * N + 8 * N;
+    desempenho->bytes_iteracao = sizeof(double) * N * N + 72 * N;
+    if (ctx->kernel.gerador != NULL)
+    {
+        desempenho->bytes_iteracao = 72 * N; // matriz regenerada: somente os vetores passam pela memoria
+    }
+    if (ctx->kernel.comprimida != NULL)
+    {
+        desempenho->bytes_iteracao = ctx->kernel.comprimida->bytes + 72 * N;
+    }
+    if (ctx->kernel.simetrica != NULL)
+    {
+        desempenho->bytes_iteracao = ctx->kernel.simetrica->bytes + 72 * N;
+    }
+    desempenho->intensidade = desempenho->flops_iteracao / desempenho->bytes_iteracao;
+    desempenho->gflops = tempo_iteracao > 0 ? desempenho->flops_iteracao / tempo_iteracao / 1e9 : 0;
+    desempenho->gbytes = tempo_iteracao > 0 ? desempenho->bytes_iteracao / tempo_iteracao / 1e9 : 0;
+    desempenho->banda_pico = banda_pico;
+    desempenho->fracao_pico = banda_pico > 0 ? desempenho->gbytes / banda_pico : 0;
+    // Teto do roofline para a intensidade aritmetica da varredura: intensidade * banda
+    desempenho->gflops_teto = desempenho->intensidade * banda_pico;
+}
+
+#ifndef JACOBI_SEM_MAIN
+
+// Opcoes do programa jacobipar que nao afetam o solver
+typedef struct
+{
+    char *chute;    // arquivo texto com o chute inicial (--chute=arquivo)
+    int passos;     // numero de passos de resolucao incremental (--passos=k)
+    int verificar;  // imprime a verificacao da solucao (--verificar)
+    int desempenho; // imprime GFLOP/s e GB/s do laco de iteracoes (--desempenho)
+    int perf;       // contadores de hardware por thread e por fase (--perf)
+    uint64_t perf_vetorial; // evento bruto de instrucoes vetoriais (--perf-vetorial=0x...)
+    char *trace;            // arquivo Chrome trace com a linha do tempo das threads (--trace=arquivo.json)
+    int autotune;           // busca e grava a melhor configuracao da varredura (--autotune)
+    int usar_tuning;        // usa a configuracao gravada pelo autotuning (desligado por --sem-tuning)
+    char *afinidade;        // politica de afinidade das threads (--afinidade=compacta|espalhada|nucleos|<cpus>)
+    int numa;               // matriz particionada entre os nos NUMA e replicas de X por no (--numa)
+    int paginas;            // tipo de pagina da matriz (--paginas=normais|thp|2m|1g)
+    char *matriz;           // sistema lido de arquivo Matrix Market ou binario (--matriz=arquivo)
+    char *vetor_b;          // vetor B do sistema lido de arquivo (--vetor-b=arquivo)
+    char *salvar_binario;   // grava o sistema no formato binario nativo (--salvar-binario=arquivo)
+    char *salvar_normalizada; // grava a imagem do sistema normalizado, mapeavel por --matriz (--salvar-normalizada=arquivo)
+    const char *cache;        // diretorio do cache de sistemas gerados por (N, seed) (--cache[=diretorio])
+    long fora_da_memoria;     // MiB de cada painel da matriz lida do disco, 0 desabilita (--fora-da-memoria[=MiB])
+    int regenerar;            // recalcula a matriz a cada varredura em vez de armazena-la (--regenerar)
+    char *checkpoint;         // grava o estado das iteracoes periodicamente (--checkpoint=arquivo)
+    double intervalo_checkpoint; // segundos entre checkpoints (--intervalo-checkpoint=s)
+    char *retomar;            // retoma as iteracoes de um checkpoint (--retomar=arquivo)
+    char *saida;              // grava a solucao, formato pela extensao (--saida=arquivo[.npy|.txt])
+    char *saida_residuo;      // grava o residuo b - Ax do sistema original (--saida-residuo=arquivo)
+    int comprimir;            // troca a matriz pela versao comprimida antes das iteracoes (--comprimir)
+    int simetrica;            // guarda somente o triangulo superior de uma matriz simetrica (--simetrica)
+    char *servidor;           // apos a resolucao, atende pedidos no socket Unix (--servidor=caminho)
+} jacobi_opcoes_main;
+
+// Le uma combinacao de criterios de parada separados por '+', ex.: variacao+residuo-inf
+int parse_criteria(char *texto)
+{
+    int criterio = criteria_from_text(texto);
+    if (criterio < 0)
+    {
+        printf("Criterio de parada desconhecido: %s\n", texto);
+        exit(0);
+    }
+    return criterio;
+}
+
+// Le as opcoes adicionais a partir de argv[primeiro]
+void parse_options(int argc, char **argv, int primeiro, jacobi_opcoes *opcoes, jacobi_opcoes_main *opcoes_main)
+{
+    jacobi_default_options(opcoes);
+    opcoes_main->chute = NULL;
+    opcoes_main->passos = 0;
+    opcoes_main->verificar = 0;
+    opcoes_main->desempenho = 0;
+    opcoes_main->perf = 0;
+    opcoes_main->perf_vetorial = perf_default_vector_event();
+    opcoes_main->trace = NULL;
+    opcoes_main->autotune = 0;
+    opcoes_main->usar_tuning = 1;
+    opcoes_main->afinidade = NULL;
+    opcoes_main->numa = 0;
+    opcoes_main->paginas = PAGINAS_THP;
+    opcoes_main->matriz = NULL;
+    opcoes_main->vetor_b = NULL;
+    opcoes_main->salvar_binario = NULL;
+    opcoes_main->salvar_normalizada = NULL;
+    opcoes_main->cache = NULL;
+    opcoes_main->fora_da_memoria = 0;
+    opcoes_main->regenerar = 0;
+    opcoes_main->checkpoint = NULL;
+    opcoes_main->intervalo_checkpoint = INTERVALO_CHECKPOINT;
+    opcoes_main->retomar = NULL;
+    opcoes_main->saida = NULL;
+    opcoes_main->saida_residuo = NULL;
+    opcoes_main->comprimir = 0;
+    opcoes_main->simetrica = 0;
+    opcoes_main->servidor = NULL;
+
+    for (int i = primeiro; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--preditor") == 0)
+        {
+            opcoes->preditor = 1;
+        }
+        else if (strncmp(argv[i], "--anderson=", 11) == 0)
+        {
+            opcoes->anderson = atoi(argv[i] + 11);
+            if (opcoes->anderson < 0 || opcoes->anderson > MAX_ANDERSON)
+            {
+                printf("Profundidade de Anderson deve estar entre 0 e %d\n", MAX_ANDERSON);
+                exit(0);
+            }
+        }
+        else if (strncmp(argv[i], "--criterio=", 11) == 0)
+        {
+            opcoes->criterio = parse_criteria(argv[i] + 11);
+        }
+        else if (strncmp(argv[i], "--tol=", 6) == 0)
+        {
+            opcoes->tol = atof(argv[i] + 6);
+        }
+        else if (strncmp(argv[i], "--atol=", 7) == 0)
+        {
+            opcoes->atol = atof(argv[i] + 7);
+        }
+        else if (strncmp(argv[i], "--max-iter=", 11) == 0)
+        {
+            opcoes->max_iteracoes = atoi(argv[i] + 11);
+        }
+        else if (strncmp(argv[i], "--chute=", 8) == 0)
+        {
+            opcoes_main->chute = argv[i] + 8;
+        }
+        else if (strcmp(argv[i], "--verificar") == 0)
+        {
+            opcoes_main->verificar = 1;
+        }
+        else if (strcmp(argv[i], "--desempenho") == 0)
+        {
+            opcoes_main->desempenho = 1;
+        }
+        else if (strcmp(argv[i], "--perf") == 0)
+        {
+            opcoes_main->perf = 1;
+        }
+        else if (strncmp(argv[i], "--perf-vetorial=", 16) == 0)
+        {
+            opcoes_main->perf = 1;
+            opcoes_main->perf_vetorial = strtoull(argv[i] + 16, NULL, 0);
+        }
+        else if (strncmp(argv[i], "--trace=", 8) == 0)
+        {
+            opcoes_main->trace = argv[i] + 8;
+        }
+        else if (strcmp(argv[i], "--autotune") == 0)
+        {
+            opcoes_main->autotune = 1;
+        }
+        else if (strcmp(argv[i], "--sem-tuning") == 0)
+        {
+            opcoes_main->usar_tuning = 0;
+        }
+        else if (strncmp(argv[i], "--afinidade=", 12) == 0)
+        {
+            static int cpus_lista[MAX_CPUS_AFINIDADE];
+            int num_lista;
+            int politica = parse_affinity(argv[i] + 12, cpus_lista, &num_lista);
+            if (politica < 0)
+            {
+                printf("Politica de afinidade desconhecida: %s\n", argv[i] + 12);
+                exit(0);
+            }
+            opcoes_main->afinidade = politica == AFINIDADE_NENHUMA ? NULL : argv[i] + 12;
+        }
+        else if (strncmp(argv[i], "--matriz=", 9) == 0)
+        {
+            opcoes_main->matriz = argv[i] + 9;
+        }
+        else if (strncmp(argv[i], "--vetor-b=", 10) == 0)
+        {
+            opcoes_main->vetor_b = argv[i] + 10;
+        }
+        else if (strncmp(argv[i], "--salvar-binario=", 17) == 0)
+        {
+            opcoes_main->salvar_binario = argv[i] + 17;
+        }
+        else if (strncmp(argv[i], "--salvar-normalizada=", 21) == 0)
+        {
+            opcoes_main->salvar_normalizada = argv[i] + 21;
+        }
+        else if (strcmp(argv[i], "--cache") == 0)
+        {
+            opcoes_main->cache = cache_dir();
+        }
+        else if (strncmp(argv[i], "--cache=", 8) == 0)
+        {
+            opcoes_main->cache = argv[i] + 8;
+        }
+        else if (strcmp(argv[i], "--fora-da-memoria") == 0)
+        {
+            opcoes_main->fora_da_memoria = PAINEL_PADRAO_MIB;
+        }
+        else if (strncmp(argv[i], "--fora-da-memoria=", 18) == 0)
+        {
+            opcoes_main->fora_da_memoria = atol(argv[i] + 18);
+            if (opcoes_main->fora_da_memoria <= 0)
+            {
+                printf("Tamanho de painel invalido: %s\n", argv[i] + 18);
+                exit(0);
+            }
+        }
+        else if (strncmp(argv[i], "--checkpoint=", 13) == 0)
+        {
+            opcoes_main->checkpoint = argv[i] + 13;
+        }
+        else if (strncmp(argv[i], "--intervalo-checkpoint=", 23) == 0)
+        {
+            opcoes_main->intervalo_checkpoint = atof(argv[i] + 23);
+        }
+        else if (strncmp(argv[i], "--retomar=", 10) == 0)
+        {
+            opcoes_main->retomar = argv[i] + 10;
+        }
+        else if (strncmp(argv[i], "--saida=", 8) == 0)
+        {
+            opcoes_main->saida = argv[i] + 8;
+        }
+        else if (strncmp(argv[i], "--saida-residuo=", 16) == 0)
+        {
+            opcoes_main->saida_residuo = argv[i] + 16;
+        }
+        else if (strncmp(argv[i], "--servidor=", 11) == 0)
+        {
+            opcoes_main->servidor = argv[i] + 11;
+        }
+        else if (strcmp(argv[i], "--simetrica") == 0)
+        {
+            opcoes_main->simetrica = 1;
+        }
+        else if (strcmp(argv[i], "--comprimir") == 0)
+        {
+            opcoes_main->comprimir = 1;
+        }
+        else if (strcmp(argv[i], "--regenerar") == 0)
+        {
+            opcoes_main->regenerar = 1;
+        }
+        else if (strncmp(argv[i], "--paginas=", 10) == 0)
+        {
+            opcoes_main->paginas = parse_pages(argv[i] + 10);
+            if (opcoes_main->paginas < 0)
+            {
+                printf("Tipo de pagina desconhecido: %s\n", argv[i] + 10);
+                exit(0);
+            }
+        }
+        else if (strcmp(argv[i], "--numa") == 0)
+        {
+            opcoes_main->numa = 1;
+        }
+        else if (strncmp(argv[i], "--passos=", 9) == 0)
+        {
+            opcoes_main->passos = atoi(argv[i] + 9);
+        }
+        else
+        {
+            printf("Opcao desconhecida: %s\n", argv[i]);
+            exit(0);
+        }
+    }
+
+    if (opcoes_main->vetor_b != NULL && opcoes_main->matriz == NULL)
+    {
+        printf("--vetor-b exige --matriz\n");
+        exit(0);
+    }
+
+    // Fora da memoria a matriz nunca esta inteira na memoria. Com o sistema gerado, --salvar-normalizada
+    // indica onde a imagem eh gravada por paineis
+    if (opcoes_main->fora_da_memoria > 0 &&
+        (opcoes_main->numa || opcoes_main->autotune || opcoes_main->salvar_binario != NULL ||
+         (opcoes_main->salvar_normalizada != NULL && opcoes_main->matriz != NULL)))
+    {
+        printf("--fora-da-memoria nao pode ser usado com --numa, --autotune, --salvar-binario ou --salvar-normalizada com --matriz\n");
+        exit(0);
+    }
+
+    // Com a matriz regenerada nao ha matriz na memoria nem em arquivo
+    if (opcoes_main->regenerar && (opcoes_main->matriz != NULL || opcoes_main->cache != NULL || opcoes_main->fora_da_memoria > 0 ||
+                                   opcoes_main->numa || opcoes_main->autotune || opcoes_main->salvar_binario != NULL ||
+                                   opcoes_main->salvar_normalizada != NULL))
+    {
+        printf("--regenerar nao pode ser usado com --matriz, --cache, --fora-da-memoria, --numa, --autotune, --salvar-binario "
+               "ou --salvar-normalizada\n");
+        exit(0);
+    }
+
+    // A matriz comprimida substitui a matriz densa, que os outros modos leem
+    if (opcoes_main->comprimir && (opcoes_main->regenerar || opcoes_main->fora_da_memoria > 0 || opcoes_main->numa ||
+                                   opcoes_main->autotune))
+    {
+        printf("--comprimir nao pode ser usado com --regenerar, --fora-da-memoria, --numa ou --autotune\n");
+        exit(0);
+    }
+
+    if (opcoes_main->simetrica && (opcoes_main->comprimir || opcoes_main->regenerar || opcoes_main->fora_da_memoria > 0 ||
+                                   opcoes_main->numa || opcoes_main->autotune))
+    {
+        printf("--simetrica nao pode ser usado com --comprimir, --regenerar, --fora-da-memoria, --numa ou --autotune\n");
+        exit(0);
+    }
+
+    // O modo NUMA depende de cada thread ficar sempre no mesmo no
+    if (opcoes_main->numa && opcoes_main->afinidade == NULL)
+    {
+        opcoes_main->afinidade = "espalhada";
+    }
+}
+
+// Le o chute inicial (N valores em texto) do arquivo nome_arq
+void read_initial_guess(char *nome_arq, double *vet_x0, int N)
+{
+    FILE *arq = fopen(nome_arq, "r");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        exit(1);
+    }
+
+    for (int i = 0; i < N; i++)
+    {
+        if (fscanf(arq, "%lf", &vet_x0[i]) != 1)
+        {
+            printf("Arquivo %s deve conter %d valores\n", nome_arq, N);
+            exit(1);
+        }
+    }
+
+    fclose(arq);
+}
+
+// Imprime o resultado de uma resolucao quando ela nao termina pelo criterio de parada
+void print_status(jacobi_contexto *ctx, int status)
+{
+    if (status == JACOBI_CONVERGENCIA_PREVISTA)
+    {
+        printf("Parada antecipada na iteracao %d: erro extrapolado abaixo da tolerancia\n", ctx->cont);
+    }
+    else if (status == JACOBI_NAO_CONVERGE)
+    {
+        if (ctx->previstas < 0)
+        {
+            printf("Abortado na iteracao %d: o sistema nao converge\n", ctx->cont);
+        }
+        else
+        {
+            printf("Abortado na iteracao %d: convergencia prevista em %d iteracoes\n", ctx->cont, ctx->previstas);
+        }
+    }
+}
+
+// Resolve do zero o sistema atual de ctx (reconstruido a partir da matriz normalizada e da diagonal) e
+// retorna a maior diferenca relativa max|x - x_novo| / max|x_novo| para a solucao incremental de ctx
+double compare_fresh_solve(jacobi_contexto *ctx, jacobi_opcoes *opcoes)
+{
+    int N = ctx->N;
+    jacobi_contexto novo;
+
+    jacobi_init(&novo, N, ctx->T);
+    for (int i = 0; i < N; i++)
+    {
+        const double *normalizada = ctx->matrix + (size_t)i * ctx->ld;
+        double *linha = novo.matrix + (size_t)i * novo.ld;
+        for (int j = 0; j < novo.ld; j++)
+        {
+            linha[j] = j < N ? normalizada[j] * ctx->vet_diag[i] : 0;
+        }
+        linha[i] = ctx->vet_diag[i];
+        novo.vet_b[i] = ctx->vet_b[i] * ctx->vet_diag[i];
+    }
+    normalize_matrix(novo.matrix, novo.vet_b, novo.vet_diag, N, novo.ld, novo.T);
+    jacobi_set_initial_guess(&novo, novo.vet_b);
+    jacobi_solve(&novo, opcoes);
+
+    double diferenca = 0;
+    double maximo = 0;
+    for (int i = 0; i < N; i++)
+    {
+        diferenca = fmax(diferenca, fabs(ctx->vet_x[i] - novo.vet_x[i]));
+        maximo = fmax(maximo, fabs(novo.vet_x[i]));
+    }
+    jacobi_free(&novo);
+    return maximo > 0 ? diferenca / maximo : diferenca;
+}
+
+int main(int argc, char **argv)
+{
+    // Argumentos de entrada
+    if (argc < 5)
+    {
+        printf("Wrong arguments. Please use main <ordem_matriz> <seed> <num_threads> <line_for_verification> [--preditor] [--anderson=<m>] [--criterio=<c1+c2>] [--tol=<tol>] [--atol=<atol>] [--max-iter=<k>] [--chute=<arquivo>] [--passos=<k>] [--verificar] [--desempenho] [--perf] [--perf-vetorial=<config>] [--trace=<arquivo.json>] [--autotune] [--sem-tuning] [--afinidade=<politica>] [--numa] [--paginas=<tipo>] [--matriz=<arquivo>] [--vetor-b=<arquivo>] [--salvar-binario=<arquivo>] [--salvar-normalizada=<arquivo>] [--cache[=<diretorio>]] [--fora-da-memoria[=<MiB>]] [--regenerar] [--checkpoint=<arquivo>] [--intervalo-checkpoint=<s>] [--retomar=<arquivo>] [--saida=<arquivo>] [--saida-residuo=<arquivo>] [--comprimir] [--simetrica] [--servidor=<socket>]\n");
+        exit(0);
+    }
+
+    int N = atoi(argv[1]);
+    int seed = atoi(argv[2]);
+    int T = atoi(argv[3]);
+    int linha = atoi(argv[4]);
+
+    jacobi_opcoes opcoes;
+    jacobi_opcoes_main opcoes_main;
+    parse_options(argc, argv, 5, &opcoes, &opcoes_main);
+
+    // Afinidade por OMP_PLACES: o programa se reexecuta com o ambiente do runtime OpenMP (nao retorna)
+    if (opcoes_main.afinidade != NULL)
+    {
+        affinity_reexec(opcoes_main.afinidade, argv);
+    }
+
+    // Fora da memoria com o sistema gerado: a imagem eh gravada por paineis em --salvar-normalizada ou no
+    // cache (ver jacobi_generate_normalized) e lida a cada varredura
+    const char *gerar_imagem = NULL;
+    if (opcoes_main.fora_da_memoria > 0 && opcoes_main.salvar_normalizada != NULL && N > 0)
+    {
+        gerar_imagem = opcoes_main.salvar_normalizada;
+        opcoes_main.matriz = opcoes_main.salvar_normalizada;
+    }
+
+    // Sistema gerado que ja esta no cache: mapeado como a imagem normalizada de --matriz
+    char nome_cache[4096];
+    int gravar_cache = 0;
+    if (opcoes_main.cache != NULL && opcoes_main.matriz == NULL && N > 0)
+    {
+        if (cache_lookup(opcoes_main.cache, N, seed, nome_cache, sizeof(nome_cache)))
+        {
+            opcoes_main.matriz = nome_cache;
+        }
+        else if (opcoes_main.fora_da_memoria > 0 && cache_create_dir(opcoes_main.cache))
+        {
+            gerar_imagem = nome_cache;
+            opcoes_main.matriz = nome_cache;
+        }
+        else
+        {
+            gravar_cache = 1;
+        }
+    }
+
+    // Sistema lido de arquivo: a ordem vem do arquivo (ordem_matriz 0 ou igual a ela) e a seed nao eh usada.
+    // A imagem normalizada eh mapeada em vez de alocada
+    int formato = -1;
+    if (gerar_imagem != NULL)
+    {
+        formato = FORMATO_NORMALIZADO;
+    }
+    else if (opcoes_main.matriz != NULL)
+    {
+        int N_arquivo = read_matrix_order(opcoes_main.matriz, &formato);
+        if (N > 0 && N != N_arquivo)
+        {
+            printf("Ordem %d diferente da ordem %d da matriz em %s\n", N, N_arquivo, opcoes_main.matriz);
+            exit(0);
+        }
+        N = N_arquivo;
+    }
+    if (opcoes_main.fora_da_memoria > 0 && formato != FORMATO_NORMALIZADO)
+    {
+        printf("--fora-da-memoria exige uma imagem normalizada (--matriz=<imagem>) ou um destino para gera-la (--cache ou "
+               "--salvar-normalizada=<imagem>)\n");
+        exit(0);
+    }
+
+    // Configuracao ajustada para esta maquina e faixa de N (num_threads <= 0: usa as threads ajustadas)
+    jacobi_kernel kernel;
+    jacobi_default_kernel(&kernel);
+    int T_ajustado = 0;
+    int ajustado = opcoes_main.usar_tuning && !opcoes_main.autotune && tune_lookup(tune_file(), N, &kernel, &T_ajustado);
+    if (T <= 0)
+    {
+        T = ajustado ? T_ajustado : omp_get_max_threads();
+    }
+    if (opcoes_main.autotune && T < omp_get_max_threads())
+    {
+        T = omp_get_max_threads(); // o autotuning pode escolher qualquer numero de threads ate o maximo
+    }
+
+    // Fixa as threads antes de gerar o sistema, para que todas as fases rodem nas mesmas cpus
+    if (opcoes_main.afinidade != NULL && !affinity_setup(opcoes_main.afinidade, T, stdout))
+    {
+        printf("Nao foi possivel fixar todas as threads nas cpus escolhidas\n");
+    }
+
+    if (opcoes_main.perf && !perf_init(T, opcoes_main.perf_vetorial))
+    {
+        printf("Contadores de hardware indisponiveis (perf_event_open falhou; verifique /proc/sys/kernel/perf_event_paranoid)\n");
+    }
+
+    if (opcoes_main.trace != NULL)
+    {
+        trace_init(T, TRACE_CAPACIDADE);
+    }
+
+    if (gerar_imagem != NULL)
+    {
+        double t0 = omp_get_wtime();
+        jacobi_generate_normalized(gerar_imagem, N, seed, (size_t)opcoes_main.fora_da_memoria << 20, T);
+        printf("Sistema de ordem %d gerado por paineis em %s em %.3f s\n", N, gerar_imagem, omp_get_wtime() - t0);
+    }
+
+    jacobi_contexto ctx;
+    int paginas = opcoes_main.paginas;
+    if (formato == FORMATO_NORMALIZADO)
+    {
+        paginas = PAGINAS_ARQUIVO;
+    }
+    else if (opcoes_main.regenerar)
+    {
+        paginas = PAGINAS_SEM_MATRIZ;
+    }
+    jacobi_init_pages(&ctx, N, T, paginas);
+    if (ctx.paginas < opcoes_main.paginas && sizeof(double) * N * ctx.ld >= PAGINA_ENORME)
+    {
+        printf("Paginas %s indisponiveis para a matriz: usando paginas %s\n", nome_paginas[opcoes_main.paginas],
+               nome_paginas[ctx.paginas]);
+    }
+
+    // Gera (ou le) e normaliza o sistema; o chute inicial padrao eh o vetor B normalizado. Fora da memoria
+    // somente os vetores sao lidos agora e a matriz eh lida a cada varredura
+    int fd_imagem = -1;
+    jacobi_imagem imagem;
+    jacobi_gerador gerador;
+    if (opcoes_main.regenerar)
+    {
+        regen_init(&gerador, &ctx, seed);
+    }
+    else if (opcoes_main.fora_da_memoria > 0)
+    {
+        fd_imagem = jacobi_open_normalized(&ctx, opcoes_main.matriz, opcoes_main.vetor_b, &imagem);
+    }
+    else if (opcoes_main.matriz != NULL)
+    {
+        double t0 = omp_get_wtime();
+        jacobi_load(&ctx, opcoes_main.matriz, opcoes_main.vetor_b);
+        printf("Sistema de ordem %d lido de %s em %.3f s\n", N, opcoes_main.matriz, omp_get_wtime() - t0);
+    }
+    else
+    {
+        jacobi_generate(&ctx, seed);
+        if (gravar_cache)
+        {
+            cache_store(&ctx, opcoes_main.cache, nome_cache);
+        }
+    }
+    if (opcoes_main.salvar_binario != NULL)
+    {
+        jacobi_save_binary(&ctx, opcoes_main.salvar_binario);
+    }
+    if (opcoes_main.salvar_normalizada != NULL && gerar_imagem == NULL)
+    {
+        jacobi_save_normalized(&ctx, opcoes_main.salvar_normalizada);
+    }
+
+    if (opcoes_main.autotune)
+    {
+        printf("Autotuning para N = %d:\n", N);
+        tune_search(&ctx, T, &kernel, &ctx.T, stdout);
+        if (tune_save(tune_file(), N, &kernel, ctx.T))
+        {
+            printf("Configuracao gravada em %s\n", tune_file());
+        }
+        ctx.kernel = kernel;
+        if (opcoes_main.afinidade != NULL && ctx.T != T)
+        {
+            affinity_setup(opcoes_main.afinidade, ctx.T, stdout); // distribuicao para o numero de threads escolhido
+        }
+    }
+    else if (ajustado)
+    {
+        ctx.kernel = kernel;
+    }
+
+    // Com afinidade, a particao estatica do laco de linhas deixa as linhas de cada thread (e de cada
+    // pacote) em um trecho contiguo e fixo da matriz entre as iteracoes
+    if (opcoes_main.afinidade != NULL && (ctx.kernel.agendamento != omp_sched_static || ctx.kernel.chunk != 0))
+    {
+        ctx.kernel.agendamento = omp_sched_static;
+        ctx.kernel.chunk = 0;
+    }
+
+    if (opcoes_main.regenerar)
+    {
+        ctx.kernel.gerador = &gerador;
+    }
+
+    // Compressao depois de gravar o sistema (--salvar-*): a matriz densa eh liberada, salvo se a solucao
+    // sera verificada (o residuo deve ser o do sistema original, nao o da matriz comprimida)
+    jacobi_comprimida comprimida;
+    if (opcoes_main.comprimir)
+    {
+        compress_matrix(&comprimida, &ctx);
+        if ((linha < 0 || linha >= N) && opcoes_main.saida_residuo == NULL)
+        {
+            free_matrix(ctx.matrix, ctx.paginas, ctx.bytes_matriz);
+            ctx.matrix = NULL;
+            ctx.bytes_matriz = 0;
+        }
+        ctx.kernel.comprimida = &comprimida;
+        compressed_report(&comprimida, stdout);
+    }
+
+    // Armazenamento simetrico, se a matriz original for simetrica (a densa eh liberada)
+    jacobi_simetrica simetrica;
+    if (opcoes_main.simetrica)
+    {
+        if (symmetric_init(&simetrica, &ctx))
+        {
+            free_matrix(ctx.matrix, ctx.paginas, ctx.bytes_matriz);
+            ctx.matrix = NULL;
+            ctx.bytes_matriz = 0;
+            ctx.kernel.simetrica = &simetrica;
+            symmetric_report(&simetrica, stdout);
+        }
+        else
+        {
+            printf("Matriz nao simetrica: usando o armazenamento denso\n");
+        }
+    }
+
+    jacobi_fluxo fluxo;
+    if (fd_imagem >= 0)
+    {
+        stream_init(&fluxo, fd_imagem, &imagem, (size_t)opcoes_main.fora_da_memoria << 20);
+        ctx.kernel.fluxo = &fluxo;
+        stream_report(&fluxo, stdout);
+    }
+
+    jacobi_numa numa;
+    if (opcoes_main.numa)
+    {
+        if (numa_setup(&numa, &ctx))
+        {
+            ctx.kernel.numa = &numa;
+            numa_report(&numa, stdout);
+        }
+        else
+        {
+            printf("Modo NUMA indisponivel (mbind falhou): usando a matriz e o vetor X compartilhados\n");
+        }
+    }
+
+    if (opcoes_main.chute != NULL)
+    {
+        double *vet_x0 = (double *)malloc(sizeof(double) * N);
+        if (vet_x0 == NULL)
+        {
+            printf("Erro de alocação de memória\n");
+            exit(1);
+        }
+        read_initial_guess(opcoes_main.chute, vet_x0, N);
+        jacobi_set_initial_guess(&ctx, vet_x0);
+        free(vet_x0);
+    }
+
+    // Retomada: o vetor X e a contagem de iteracoes do checkpoint substituem o chute inicial
+    if (opcoes_main.retomar != NULL)
+    {
+        opcoes.iteracao_inicial = checkpoint_load(opcoes_main.retomar, &ctx, &opcoes);
+        printf("Retomando de %s na iteracao %d (erro %g)\n", opcoes_main.retomar, opcoes.iteracao_inicial, ctx.error);
+    }
+
+    jacobi_checkpoint checkpoint;
+    if (opcoes_main.checkpoint != NULL)
+    {
+        checkpoint_init(&checkpoint, opcoes_main.checkpoint, opcoes_main.intervalo_checkpoint, &ctx, &opcoes);
+        opcoes.checkpoint = &checkpoint;
+    }
+
+    int status = jacobi_solve(&ctx, &opcoes);
+    print_status(&ctx, status);
+
+    // O checkpoint cobre somente a primeira resolucao: os passos seguintes mudam o vetor B
+    if (opcoes.checkpoint != NULL)
+    {
+        checkpoint_free(&checkpoint);
+        if (checkpoint.falhas > 0)
+        {
+            printf("Falha ao gravar %d checkpoint(s) em %s\n", checkpoint.falhas, opcoes_main.checkpoint);
+        }
+        opcoes.checkpoint = NULL;
+    }
+    opcoes.iteracao_inicial = 0;
+
+    // Sequencia de sistemas em que poucos elementos de B e uma linha da matriz mudam levemente entre
+    // passos: cada passo reaproveita a normalizacao e parte da solucao do passo anterior
+    if (opcoes_main.passos > 0)
+    {
+        int k = N / 100 + 1; // elementos de B alterados por passo
+        int *indices = (int *)malloc(sizeof(int) * k);
+        double *valores = (double *)malloc(sizeof(double) * k);
+        double *nova_linha = (double *)malloc(sizeof(double) * N);
+        if (indices == NULL || valores == NULL || nova_linha == NULL)
+        {
+            printf("Erro de alocação de memória\n");
+            exit(1);
+        }
+
+        // Atualizacao vazia: somente verifica se a varredura deste modo le ctx->matrix
+        int alterar_linhas = jacobi_update_rows(&ctx, NULL, NULL, 0);
+        if (!alterar_linhas)
+        {
+            printf("A matriz nao pode ser alterada neste modo: os passos alteram somente o vetor B\n");
+        }
+        printf("Passo 0: %d iteracoes\n", ctx.cont);
+        for (int passo = 1; passo <= opcoes_main.passos && status != JACOBI_NAO_CONVERGE; passo++)
+        {
+            for (int c = 0; c < k; c++)
+            {
+                indices[c] = rand() % N;
+                // B original perturbado em ate 1%
+                valores[c] = ctx.vet_b[indices[c]] * ctx.vet_diag[indices[c]] * (1 + ((rand() % 201) - 100) / 10000.0);
+            }
+            jacobi_update_b(&ctx, indices, valores, k);
+
+            // Linha original com os elementos fora da diagonal perturbados em ate 1% e a diagonal aumentada
+            // em 1%, o que preserva a dominancia diagonal
+            if (alterar_linhas)
+            {
+                int i = rand() % N;
+                const double *normalizada = ctx.matrix + (size_t)i * ctx.ld;
+                for (int j = 0; j < N; j++)
+                {
+                    nova_linha[j] = normalizada[j] * ctx.vet_diag[i] * (1 + ((rand() % 201) - 100) / 10000.0);
+                }
+                nova_linha[i] = ctx.vet_diag[i] * 1.01;
+                if (!jacobi_update_rows(&ctx, &i, nova_linha, 1))
+                {
+                    printf("Linha %d rejeitada por jacobi_update_rows\n", i);
+                    exit(1);
+                }
+            }
+
+            status = jacobi_solve(&ctx, &opcoes);
+            print_status(&ctx, status);
+            printf("Passo %d: %d iteracoes\n", passo, ctx.cont);
+        }
+
+        // Com --verificar, a solucao incremental eh comparada com a de uma resolucao do zero do sistema
+        // modificado
+        if (opcoes_main.verificar && alterar_linhas && status != JACOBI_NAO_CONVERGE)
+        {
+            printf("Diferenca relativa para a resolucao do zero do sistema modificado: %g\n", compare_fresh_solve(&ctx, &opcoes));
+        }
+
+        free(indices);
+        free(valores);
+        free(nova_linha);
+    }
+
+    // Modo servidor: o sistema fica na memoria e cada pedido parte da solucao atual. A gravacao e a
+    // verificacao seguintes usam a solucao do ultimo pedido
+    if (opcoes_main.servidor != NULL)
+    {
+        serve(&ctx, &opcoes, opcoes_main.servidor);
+    }
+
+    // A solucao eh gravada em segundo plano enquanto a verificacao e as medidas seguem
+    jacobi_saida saida;
+    if (opcoes_main.saida != NULL)
+    {
+        output_start(&saida, opcoes_main.saida, output_format(opcoes_main.saida), ctx.vet_x, N);
+    }
+    jacobi_saida saida_residuo;
+
+    // Verificacao da solucao: residuo de todas as linhas do sistema original
+    if ((linha >= 0 && linha < N) || opcoes_main.saida_residuo != NULL)
+    {
+        double *vet_r = (double *)malloc(sizeof(double) * N);
+        if (vet_r == NULL)
+        {
+            printf("Erro de alocação de memória\n");
+            exit(1);
+        }
+
+        jacobi_verificacao verificacao;
+        jacobi_verify(&ctx, vet_r, &verificacao);
+
+        if (opcoes_main.saida_residuo != NULL)
+        {
+            output_start(&saida_residuo, opcoes_main.saida_residuo, output_format(opcoes_main.saida_residuo), vet_r, N);
+        }
+
+        // Avalia a equacao da linha escolhida com o valor do vetor X: A[linha].x = b[linha] - r[linha]
+        if (opcoes_main.verificar && linha >= 0 && linha < N)
+        {
+            double esperado = ctx.vet_b[linha] * ctx.vet_diag[linha];
+            double result = esperado - vet_r[linha];
+            printf("Valor esperado: %f\n", esperado);
+            printf("Resultado da atribuicao na linha %d (%d iteracoes): %.6f\n", linha, ctx.cont, result);
+            printf("Erro: %.6f\n", ctx.error);
+            printf("Residuo: %g (max, linha %d), %g (L2), %g (relativo)\n", verificacao.residuo_max, verificacao.linha_max,
+                   verificacao.residuo_2, verificacao.residuo_relativo);
+            if (ctx.kernel.comprimida != NULL)
+            {
+                printf("Residuo em relacao a matriz %s (compressao com erro maximo %g por elemento normalizado)\n",
+                       ctx.matrix != NULL ? "original" : "comprimida", comprimida.erro_max);
+            }
+        }
+
+        free(vet_r);
+    }
+
+    if (opcoes_main.desempenho)
+    {
+        jacobi_desempenho desempenho;
+        jacobi_performance(&ctx, measure_stream_bandwidth(T), &desempenho);
+        printf("Tempo por iteracao: %.6e s (%d iteracoes)\n", desempenho.tempo_iteracao, ctx.cont);
+        printf("Vazao: %.3f GFLOP/s, %.3f GB/s (intensidade %.3f flop/byte)\n", desempenho.gflops, desempenho.gbytes,
+               desempenho.intensidade);
+        printf("Banda STREAM triad: %.3f GB/s -> %.1f%% do pico, teto do roofline %.3f GFLOP/s\n", desempenho.banda_pico,
+               100 * desempenho.fracao_pico, desempenho.gflops_teto);
+        if (desempenho.fracao_pico > 1)
+        {
+            printf("Varredura acima da banda da DRAM: matriz servida pela cache\n");
+        }
+        else if (desempenho.fracao_pico >= LIMIAR_LIMITADO_BANDA)
+        {
+            printf("Varredura limitada pela banda de memoria\n");
+        }
+        else
+        {
+            printf("Varredura abaixo do teto de banda: limitada por computacao, latencia ou sincronizacao\n");
+        }
+    }
+
+    if (perf_ativo)
+    {
+        perf_report(stdout);
+        perf_finish();
+    }
+
+    if (opcoes_main.trace != NULL)
+    {
+        trace_dump(opcoes_main.trace);
+        trace_finish();
+    }
+
+    if (opcoes_main.saida != NULL && !output_finish(&saida))
+    {
+        printf("Erro ao gravar o arquivo %s\n", opcoes_main.saida);
+    }
+    if (opcoes_main.saida_residuo != NULL && !output_finish(&saida_residuo))
+    {
+        printf("Erro ao gravar o arquivo %s\n", opcoes_main.saida_residuo);
+    }
+
+    if (ctx.kernel.numa != NULL)
+    {
+        numa_free(&numa);
+    }
+    if (ctx.kernel.comprimida != NULL)
+    {
+        compressed_free(&comprimida);
+    }
+    if (ctx.kernel.simetrica != NULL)
+    {
+        symmetric_free(&simetrica);
+    }
+    if (ctx.kernel.fluxo != NULL)
+    {
+        if (opcoes_main.desempenho)
+        {
+            stream_report(&fluxo, stdout);
+        }
+        stream_free(&fluxo);
+    }
+    jacobi_free(&ctx);
+
+    return status == JACOBI_NAO_CONVERGE ? 2 : 0;
+}
+
+#endif
@@ -0,0 +1,195 @@
+// Solver de Jacobi-Richardson paralelo (OpenMP): tipos, constantes e funcoes usadas pelo programa
+// jacobipar e por outros programas que ligam o solver (compilar jacobipar.c com -DJACOBI_SEM_MAIN)
+
+#ifndef JACOBIPAR_H
+#define JACOBIPAR_H
+
+#include <omp.h>
+#include <string.h>
+
+#include "jacobimem.h"
+
+#define MAX_ITERACOES 50000
+#define MAX_MATRIX_VALUE 1000
+#define PRECISAO_JACOBI 0.001
+#define JANELA_PREDITOR 50     // numero de erros usados para estimar a taxa de convergencia
+#define ESTABILIDADE_TAXA 0.05 // variacao relativa maxima da taxa entre as metades da janela
+#define MAX_ANDERSON 32        // profundidade maxima do historico da aceleracao de Anderson
+#define REGULARIZACAO_ANDERSON 1e-12
+#define TAMANHO_STREAM (1L << 24) // elementos de cada vetor do STREAM triad (128 MiB)
+#define REPETICOES_STREAM 5
+#define LIMIAR_LIMITADO_BANDA 0.7 // fracao da banda STREAM a partir da qual a varredura eh limitada por memoria
+
+// Resultado do laco de iteracoes
+#define JACOBI_CONVERGIU 0
+#define JACOBI_MAX_ITERACOES 1
+#define JACOBI_CONVERGENCIA_PREVISTA 2 // parada antecipada: erro extrapolado ja abaixo da precisao
+#define JACOBI_NAO_CONVERGE 3          // abortado: iteracoes previstas excedem o limite de iteracoes
+
+// Criterios de parada (combinaveis): todos os criterios escolhidos devem ser satisfeitos
+#define CRITERIO_VARIACAO 1    // variacao relativa max|x(k+1) - x(k)| / max|x(k+1)| <= tol
+#define CRITERIO_RESIDUO_INF 2 // |b - Ax|inf <= max(atol, tol * |b|inf)
+#define CRITERIO_RESIDUO_2 4   // |b - Ax|2 <= max(atol, tol * |b|2)
+#define CRITERIOS_VALIDOS (CRITERIO_VARIACAO | CRITERIO_RESIDUO_INF | CRITERIO_RESIDUO_2)
+
+// Combinacao de criterios a partir dos nomes separados por '+', ex.: variacao+residuo-inf. Retorna -1 se
+// algum nome eh desconhecido (usada tambem pelo cliente do modo servidor, que nao liga o solver)
+static inline int criteria_from_text(const char *texto)
+{
+    int criterio = 0;
+    while (1)
+    {
+        size_t n = strcspn(texto, "+");
+        if (n == 8 && strncmp(texto, "variacao", n) == 0)
+        {
+            criterio |= CRITERIO_VARIACAO;
+        }
+        else if (n == 11 && strncmp(texto, "residuo-inf", n) == 0)
+        {
+            criterio |= CRITERIO_RESIDUO_INF;
+        }
+        else if (n == 9 && strncmp(texto, "residuo-2", n) == 0)
+        {
+            criterio |= CRITERIO_RESIDUO_2;
+        }
+        else
+        {
+            return -1;
+        }
+        if (texto[n] == '\0')
+        {
+            return criterio;
+        }
+        texto += n + 1;
+    }
+}
+
+// Variantes da varredura de calculate_new_x
+#define KERNEL_LINHAS 0 // uma linha por vez
+#define KERNEL_BLOCOS 1 // bloco_linhas linhas por vez, em faixas de bloco_colunas colunas
+#define MAX_BLOCO_LINHAS 8
+
+struct jacobi_numa;  // replicas de X por no NUMA (jacobinuma.h)
+struct jacobi_fluxo; // matriz lida do disco em paineis (jacobistream.h)
+struct jacobi_gerador; // matriz regenerada a cada varredura (jacobiregen.h)
+struct jacobi_checkpoint; // gravacao periodica do estado das iteracoes (jacobickpt.h)
+struct jacobi_comprimida; // matriz em blocos com expoente compartilhado (jacobicomp.h)
+struct jacobi_simetrica;  // triangulo superior de uma matriz simetrica (jacobisim.h)
+
+// Parametros da varredura (escolhidos pelo autotuning)
+typedef struct
+{
+    int variante;             // KERNEL_LINHAS ou KERNEL_BLOCOS
+    int bloco_linhas;         // linhas por bloco (1, 2, 4 ou 8) em KERNEL_BLOCOS
+    int bloco_colunas;        // colunas por faixa em KERNEL_BLOCOS, 0 para a linha inteira
+    omp_sched_t agendamento;  // agendamento OpenMP do laco de linhas
+    int chunk;                // tamanho do chunk do agendamento, 0 para o padrao
+    const struct jacobi_numa *numa; // replicas de X lidas pela varredura, NULL desabilita (modo NUMA)
+    struct jacobi_fluxo *fluxo;     // matriz lida do disco a cada varredura, NULL: ctx->matrix (modo fora da memoria)
+    const struct jacobi_gerador *gerador; // matriz recalculada a cada varredura, NULL: ctx->matrix (--regenerar)
+    const struct jacobi_comprimida *comprimida; // matriz comprimida lida pela varredura, NULL: ctx->matrix (--comprimir)
+    struct jacobi_simetrica *simetrica;         // blocos do triangulo superior, NULL: ctx->matrix (--simetrica)
+} jacobi_kernel;
+
+// Opcoes adicionais (opcionais) passadas apos os argumentos obrigatorios
+typedef struct
+{
+    int preditor;      // habilita o preditor de convergencia (--preditor)
+    int anderson;      // profundidade m do historico da aceleracao de Anderson, 0 desabilita (--anderson=m)
+    int criterio;      // combinacao de CRITERIO_* (--criterio=variacao+residuo-inf+residuo-2)
+    double tol;        // tolerancia relativa (--tol), PRECISAO_JACOBI por padrao
+    double atol;       // tolerancia absoluta dos criterios de residuo (--atol), 0 desabilita
+    int max_iteracoes; // limite de iteracoes (--max-iter), MAX_ITERACOES por padrao
+    int iteracao_inicial; // iteracoes ja feitas ate o chute inicial (retomada de checkpoint), contam no limite
+    struct jacobi_checkpoint *checkpoint; // recebe o estado periodicamente, NULL desabilita (--checkpoint)
+} jacobi_opcoes;
+
+// Contexto de um sistema Ax = b mantido entre resolucoes: a matriz normalizada, vet_b e vet_diag sao
+// reaproveitados e a solucao anterior serve de chute inicial para a proxima resolucao
+typedef struct
+{
+    int N;              // ordem da matriz
+    int T;              // numero de threads
+    int ld;             // distancia entre linhas consecutivas da matriz (>= N, ver leading_dimension)
+    double *matrix;     // matriz A normalizada (linearizada, linha i em matrix[i * ld]), com diagonal zerada
+    double *vet_b;      // vetor B normalizado
+    double *vet_diag;   // diagonal original da matriz A
+    double *vet_x;      // solucao atual (ao final de jacobi_solve, igual a vet_new_x)
+    double *vet_new_x;  // proximo chute
+    int cont;           // iteracoes realizadas na ultima resolucao
+    double error;       // erro da ultima iteracao
+    double residuo_inf; // |b - Ax|inf do penultimo vetor X (calculado na varredura da ultima iteracao)
+    double residuo_2;   // |b - Ax|2 do penultimo vetor X
+    int previstas;      // iteracoes previstas pelo preditor de convergencia (-1: nao converge)
+    double tempo_iteracoes; // tempo (s) do laco de iteracoes da ultima resolucao
+    jacobi_kernel kernel;   // parametros da varredura
+    int paginas;            // tipo de pagina obtido para a matriz (PAGINAS_*)
+    size_t bytes_matriz;    // bytes reservados para a matriz
+} jacobi_contexto;
+
+// Resultado da verificacao da solucao (residuo r = b - Ax do sistema original)
+typedef struct
+{
+    double residuo_max;      // |r|inf
+    int linha_max;           // linha com o maior residuo
+    double residuo_2;        // |r|2
+    double residuo_relativo; // |r|inf / |b|inf
+} jacobi_verificacao;
+
+// Vazao do laco de iteracoes (modelo roofline)
+typedef struct
+{
+    double tempo_iteracao; // segundos por iteracao
+    double flops_iteracao; // operacoes de ponto flutuante por iteracao
+    double bytes_iteracao; // bytes movidos por iteracao
+    double intensidade;    // flops / byte
+    double gflops;         // GFLOP/s obtidos
+    double gbytes;         // GB/s efetivos
+    double banda_pico;     // GB/s do STREAM triad
+    double fracao_pico;    // gbytes / banda_pico
+    double gflops_teto;    // intensidade * banda_pico
+} jacobi_desempenho;
+
+// Estado da aceleracao de Anderson sobre a iteracao de ponto fixo x = g(x) = B* - A*.x
+typedef struct
+{
+    int m;         // profundidade do historico
+    int k;         // numero de iteracoes acumuladas desde o ultimo reinicio
+    double *df;    // m vetores f(k) - f(k-1), com f(k) = g(x(k)) - x(k)
+    double *dg;    // m vetores g(x(k)) - g(x(k-1))
+    double *f_ant; // f da iteracao anterior
+    double *g_ant; // g(x) da iteracao anterior
+    double *gram;  // m x m produtos internos df[a] . df[b]
+    double *rhs;   // produtos internos df[a] . f(k)
+    double *gamma; // coeficientes da combinacao (minimos quadrados)
+} jacobi_anderson;
+
+
+void init_matrix(double *matrix, double *vet_b, int N, int ld);
+void init_rows(double *linhas, double *vet_b, int i0, int i1, int N, int ld);
+void normalize_matrix(double *matrix, double *vet_b, double *vet_diag, int N, int ld, int T);
+void normalize_rows(double *linhas, double *vet_b, double *vet_diag, int i0, int i1, int ld, int T);
+void calculate_new_x(double *matrix, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x, double *residuo,
+                     const jacobi_kernel *kernel, int N, int ld, int T);
+void calculate_error(double *vet_x, double *vet_new_x, double *error, int N, int T);
+
+void anderson_init(jacobi_anderson *anderson, int m, int N);
+void anderson_free(jacobi_anderson *anderson);
+void anderson_mix(jacobi_anderson *anderson, double *vet_x, double *vet_new_x, int N, int T);
+int predict_convergence(double *hist_erro, int cont, double error, int max_iteracoes, int antecipar, int *previstas);
+
+void jacobi_default_options(jacobi_opcoes *opcoes);
+void jacobi_default_kernel(jacobi_kernel *kernel);
+void jacobi_init(jacobi_contexto *ctx, int N, int T);
+void jacobi_init_pages(jacobi_contexto *ctx, int N, int T, int paginas);
+void jacobi_free(jacobi_contexto *ctx);
+void jacobi_generate(jacobi_contexto *ctx, int seed);
+void jacobi_set_initial_guess(jacobi_contexto *ctx, const double *vet_x0);
+void jacobi_update_b(jacobi_contexto *ctx, const int *indices, const double *valores, int k);
+int jacobi_update_rows(jacobi_contexto *ctx, const int *linhas, const double *valores, int k);
+int jacobi_solve(jacobi_contexto *ctx, const jacobi_opcoes *opcoes);
+void jacobi_verify(jacobi_contexto *ctx, double *vet_r, jacobi_verificacao *verificacao);
+double measure_stream_bandwidth(int T);
+void jacobi_performance(jacobi_contexto *ctx, double banda_pico, jacobi_desempenho *desempenho);
+
+#endif
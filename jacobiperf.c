@@ -0,0 +1,343 @@
+// Contadores de hardware por thread via perf_event_open (somente Linux). Cada thread do time OpenMP abre
+// um grupo de eventos para si mesma; a thread mestre le os grupos de todas as threads no inicio e no fim
+// de cada fase e acumula as diferencas por (fase, thread, evento).
+//
+// Os contadores sao do sistema operacional, por thread: a linha t do relatorio eh a thread que era a
+// t-esima do time em perf_init. Isso supoe que o runtime reaproveita as mesmas threads, na mesma ordem,
+// nas regioes seguintes (o caso do libgomp com o mesmo numero de threads e, com --afinidade, garantido
+// pelo vinculo OMP_PLACES). O relatorio confere a suposicao e avisa se o time mudou.
+//
+// Quando ha mais eventos que contadores livres (ex.: um contador ocupado pelo watchdog NMI), o kernel
+// multiplexa os grupos: cada leitura traz os tempos habilitado e em execucao, os valores sao escalados
+// por habilitado / em execucao e as linhas estimadas sao marcadas no relatorio
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <omp.h>
+
+#include "jacobiperf.h"
+
+int perf_ativo = 0;
+
+const char *nome_fases_perf[PERF_NUM_FASES] = {"init_matrix", "normalize_matrix", "calculate_new_x", "calculate_error"};
+const char *nome_eventos_perf[PERF_NUM_EVENTOS] = {"ciclos", "instrucoes", "LLC misses", "dTLB misses", "vetoriais"};
+
+#ifdef __linux__
+
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+static int num_threads_perf = 0;
+static int lider[PERF_MAX_THREADS];                       // fd do lider do grupo de cada thread (-1: sem contadores)
+static int posicao[PERF_MAX_THREADS][PERF_NUM_EVENTOS];   // posicao do evento na leitura do grupo (-1: nao aberto)
+static int abertos[PERF_MAX_THREADS];                     // eventos abertos no grupo
+static pid_t tid[PERF_MAX_THREADS];                        // thread do sistema de cada thread do time em perf_init
+static uint64_t inicio[PERF_MAX_THREADS][PERF_NUM_EVENTOS + 2]; // valores, tempo habilitado e em execucao
+static uint64_t acumulado[PERF_NUM_FASES][PERF_MAX_THREADS][PERF_NUM_EVENTOS]; // valores escalados
+static uint64_t habilitado[PERF_NUM_FASES][PERF_MAX_THREADS]; // ns com o grupo habilitado durante a fase
+static uint64_t executando[PERF_NUM_FASES][PERF_MAX_THREADS]; // ns com o grupo de fato contando
+static int disponivel[PERF_NUM_EVENTOS]; // evento aberto em pelo menos uma thread
+static double tempo_inicio;
+static double tempo_fase[PERF_NUM_FASES];
+static long chamadas[PERF_NUM_FASES];
+
+static int open_event(uint32_t tipo, uint64_t config, int grupo)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = tipo;
+    attr.config = config;
+    attr.disabled = grupo == -1; // o grupo inteiro eh habilitado pelo lider
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    // pid = 0, cpu = -1: conta a thread chamadora em qualquer cpu
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, grupo, 0);
+}
+
+// Abre os contadores em cada uma das T threads. config_vetorial eh a configuracao bruta (PERF_TYPE_RAW) do
+// evento de instrucoes vetoriais, 0 para nao contar. Retorna 0 se nenhum contador pode ser aberto
+int perf_init(int T, uint64_t config_vetorial)
+{
+    uint32_t tipos[PERF_NUM_EVENTOS] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                        PERF_TYPE_HW_CACHE, PERF_TYPE_RAW};
+    uint64_t configs[PERF_NUM_EVENTOS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+        PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        config_vetorial};
+
+    if (T > PERF_MAX_THREADS)
+    {
+        T = PERF_MAX_THREADS;
+    }
+    num_threads_perf = T;
+    memset(acumulado, 0, sizeof(acumulado));
+    memset(habilitado, 0, sizeof(habilitado));
+    memset(executando, 0, sizeof(executando));
+    memset(tempo_fase, 0, sizeof(tempo_fase));
+    memset(chamadas, 0, sizeof(chamadas));
+    memset(disponivel, 0, sizeof(disponivel));
+
+    // Supoe que as threads do time sao reaproveitadas pelas regioes seguintes (conferido em perf_report)
+#pragma omp parallel num_threads(T)
+    {
+        int t = omp_get_thread_num();
+        tid[t] = (pid_t)syscall(SYS_gettid);
+        lider[t] = -1;
+        abertos[t] = 0;
+        for (int e = 0; e < PERF_NUM_EVENTOS; e++)
+        {
+            posicao[t][e] = -1;
+            if (e == PERF_VETORIAIS && config_vetorial == 0)
+            {
+                continue;
+            }
+            int fd = open_event(tipos[e], configs[e], lider[t]);
+            if (fd < 0)
+            {
+                continue;
+            }
+            if (lider[t] == -1)
+            {
+                lider[t] = fd;
+            }
+            posicao[t][e] = abertos[t]++;
+#pragma omp atomic write
+            disponivel[e] = 1;
+        }
+        if (lider[t] != -1)
+        {
+            ioctl(lider[t], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ioctl(lider[t], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    int algum = 0;
+    for (int e = 0; e < PERF_NUM_EVENTOS; e++)
+    {
+        algum |= disponivel[e];
+    }
+    perf_ativo = algum;
+    return algum;
+}
+
+// Le o grupo de contadores da thread t: valores[e] e, em valores[PERF_NUM_EVENTOS] e
+// valores[PERF_NUM_EVENTOS + 1], os tempos habilitado e em execucao do grupo (eventos nao abertos ficam
+// com 0). Formato da leitura: nr, habilitado, em execucao, nr valores
+static void read_group(int t, uint64_t *valores)
+{
+    uint64_t buffer[3 + PERF_NUM_EVENTOS];
+
+    memset(valores, 0, sizeof(uint64_t) * (PERF_NUM_EVENTOS + 2));
+    if (lider[t] == -1 || read(lider[t], buffer, sizeof(uint64_t) * (3 + abertos[t])) <= 0)
+    {
+        return;
+    }
+    for (int e = 0; e < PERF_NUM_EVENTOS; e++)
+    {
+        if (posicao[t][e] >= 0)
+        {
+            valores[e] = buffer[3 + posicao[t][e]];
+        }
+    }
+    valores[PERF_NUM_EVENTOS] = buffer[1];
+    valores[PERF_NUM_EVENTOS + 1] = buffer[2];
+}
+
+void perf_begin(int fase)
+{
+    for (int t = 0; t < num_threads_perf; t++)
+    {
+        read_group(t, inicio[t]);
+    }
+    tempo_inicio = omp_get_wtime();
+}
+
+// Acumula as diferencas da fase, escaladas por habilitado / em execucao quando o grupo foi multiplexado
+// (sem tempo em execucao nao ha estimativa: a fase fica sem contagem e eh marcada no relatorio)
+void perf_end(int fase)
+{
+    uint64_t valores[PERF_NUM_EVENTOS + 2];
+
+    tempo_fase[fase] += omp_get_wtime() - tempo_inicio;
+    chamadas[fase]++;
+    for (int t = 0; t < num_threads_perf; t++)
+    {
+        read_group(t, valores);
+        uint64_t d_habilitado = valores[PERF_NUM_EVENTOS] - inicio[t][PERF_NUM_EVENTOS];
+        uint64_t d_executando = valores[PERF_NUM_EVENTOS + 1] - inicio[t][PERF_NUM_EVENTOS + 1];
+        habilitado[fase][t] += d_habilitado;
+        executando[fase][t] += d_executando;
+        double escala = d_executando > 0 && d_executando < d_habilitado ? (double)d_habilitado / d_executando : 1;
+        for (int e = 0; e < PERF_NUM_EVENTOS; e++)
+        {
+            acumulado[fase][t][e] += (uint64_t)((valores[e] - inicio[t][e]) * escala + 0.5);
+        }
+    }
+}
+
+// Confere se o time de num_threads_perf threads ainda eh formado pelas threads de perf_init, na mesma ordem
+static int same_team(void)
+{
+    int mesmas = 1;
+#pragma omp parallel num_threads(num_threads_perf) reduction(& : mesmas)
+    {
+        int t = omp_get_thread_num();
+        mesmas &= omp_get_num_threads() == num_threads_perf && tid[t] == (pid_t)syscall(SYS_gettid);
+    }
+    return mesmas;
+}
+
+void perf_finish(void)
+{
+    for (int t = 0; t < num_threads_perf; t++)
+    {
+        if (lider[t] != -1)
+        {
+            ioctl(lider[t], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            close(lider[t]); // os demais fds do grupo sao liberados no fim do processo
+            lider[t] = -1;
+        }
+    }
+    perf_ativo = 0;
+}
+
+// Evento bruto de instrucoes vetoriais de ponto flutuante: FP_ARITH_INST_RETIRED (evento 0xC7) com as
+// mascaras de todas as larguras empacotadas (128, 256 e 512 bits) nos processadores Intel. Em outros
+// fabricantes retorna 0 (use --perf-vetorial=<config> com o evento bruto do processador)
+uint64_t perf_default_vector_event(void)
+{
+    char linha[256];
+    uint64_t config = 0;
+    FILE *arq = fopen("/proc/cpuinfo", "r");
+    if (arq == NULL)
+    {
+        return 0;
+    }
+    while (fgets(linha, sizeof(linha), arq) != NULL)
+    {
+        if (strncmp(linha, "vendor_id", 9) == 0)
+        {
+            config = strstr(linha, "GenuineIntel") != NULL ? 0xFCC7 : 0;
+            break;
+        }
+    }
+    fclose(arq);
+    return config;
+}
+
+#else
+
+int perf_init(int T, uint64_t config_vetorial)
+{
+    return 0;
+}
+
+void perf_begin(int fase)
+{
+}
+
+void perf_end(int fase)
+{
+}
+
+void perf_finish(void)
+{
+}
+
+uint64_t perf_default_vector_event(void)
+{
+    return 0;
+}
+
+#endif
+
+// Relatorio: para cada fase, tempo, chamadas e contadores por thread e totais, com IPC, misses por mil
+// instrucoes e a fracao do tempo em que os contadores estavam de fato contando
+void perf_report(FILE *arq)
+{
+#ifdef __linux__
+    int multiplexado = 0;
+    for (int f = 0; f < PERF_NUM_FASES; f++)
+    {
+        if (chamadas[f] == 0)
+        {
+            continue;
+        }
+
+        fprintf(arq, "%s: %ld chamadas, %.6f s\n", nome_fases_perf[f], chamadas[f], tempo_fase[f]);
+        fprintf(arq, "%8s", "thread");
+        for (int e = 0; e < PERF_NUM_EVENTOS; e++)
+        {
+            if (disponivel[e])
+            {
+                fprintf(arq, " %16s", nome_eventos_perf[e]);
+            }
+        }
+        fprintf(arq, " %8s %10s %8s\n", "IPC", "LLC/kinst", "contando");
+
+        uint64_t total[PERF_NUM_EVENTOS] = {0};
+        uint64_t total_habilitado = 0;
+        uint64_t total_executando = 0;
+        for (int t = 0; t <= num_threads_perf; t++)
+        {
+            uint64_t *valores = t < num_threads_perf ? acumulado[f][t] : total;
+            uint64_t h = t < num_threads_perf ? habilitado[f][t] : total_habilitado;
+            uint64_t x = t < num_threads_perf ? executando[f][t] : total_executando;
+            if (t < num_threads_perf)
+            {
+                fprintf(arq, "%8d", t);
+                for (int e = 0; e < PERF_NUM_EVENTOS; e++)
+                {
+                    total[e] += valores[e];
+                }
+                total_habilitado += h;
+                total_executando += x;
+            }
+            else
+            {
+                fprintf(arq, "%8s", "total");
+            }
+            for (int e = 0; e < PERF_NUM_EVENTOS; e++)
+            {
+                if (disponivel[e])
+                {
+                    fprintf(arq, " %16llu", (unsigned long long)valores[e]);
+                }
+            }
+            double ipc = valores[PERF_CICLOS] > 0 ? (double)valores[PERF_INSTRUCOES] / valores[PERF_CICLOS] : 0;
+            double llc = valores[PERF_INSTRUCOES] > 0 ? 1000.0 * valores[PERF_LLC_MISSES] / valores[PERF_INSTRUCOES] : 0;
+            fprintf(arq, " %8.3f %10.3f", ipc, llc);
+
+            // Fracao do tempo habilitado em que o grupo contou: abaixo de 100% os valores sao estimados
+            // (*) e sem nenhum tempo contando nao ha valores (!)
+            if (h == 0)
+            {
+                fprintf(arq, " %8s\n", "-");
+            }
+            else
+            {
+                fprintf(arq, " %7.1f%%%s\n", 100.0 * x / h, x == 0 ? " !" : x < h ? " *" : "");
+                multiplexado |= x < h;
+            }
+        }
+        fprintf(arq, "\n");
+    }
+
+    if (multiplexado)
+    {
+        fprintf(arq, "* grupo multiplexado: valores escalados por tempo habilitado / em execucao (estimativas)\n");
+        fprintf(arq, "! grupo nunca escalonado (contadores ocupados, ex.: watchdog NMI): valores indisponiveis\n");
+    }
+    if (num_threads_perf > 0 && !same_team())
+    {
+        fprintf(arq, "Aviso: o time OpenMP nao eh mais formado pelas threads de perf_init; os valores por thread podem "
+                     "misturar threads (use --afinidade)\n");
+    }
+#endif
+}
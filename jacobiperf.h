@@ -0,0 +1,50 @@
+// Instrumentacao opcional com contadores de hardware (perf_event_open) por thread, agregados por fase
+// do solver. Quando desabilitada (perf_ativo == 0) cada marcacao custa apenas um teste
+
+#ifndef JACOBIPERF_H
+#define JACOBIPERF_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Fases instrumentadas
+#define PERF_INIT_MATRIX 0
+#define PERF_NORMALIZE_MATRIX 1
+#define PERF_CALCULATE_NEW_X 2
+#define PERF_CALCULATE_ERROR 3
+#define PERF_NUM_FASES 4
+
+// Eventos lidos de cada thread
+#define PERF_CICLOS 0
+#define PERF_INSTRUCOES 1
+#define PERF_LLC_MISSES 2
+#define PERF_DTLB_MISSES 3
+#define PERF_VETORIAIS 4 // evento bruto dependente do processador (ver perf_init)
+#define PERF_NUM_EVENTOS 5
+
+#define PERF_MAX_THREADS 256
+
+extern int perf_ativo;
+
+// Marca inicio/fim de uma fase (chamadas fora das regioes paralelas, pela thread mestre)
+#define PERF_INICIO(fase)     \
+    do                        \
+    {                         \
+        if (perf_ativo)       \
+            perf_begin(fase); \
+    } while (0)
+#define PERF_FIM(fase)      \
+    do                      \
+    {                       \
+        if (perf_ativo)     \
+            perf_end(fase); \
+    } while (0)
+
+int perf_init(int T, uint64_t config_vetorial);
+void perf_begin(int fase);
+void perf_end(int fase);
+void perf_report(FILE *arq);
+void perf_finish(void);
+uint64_t perf_default_vector_event(void);
+
+#endif
@@ -0,0 +1,117 @@
+// Geracao da matriz por contador: a_ij = h(chave(seed, i), j), com h um hash de 32 bits, reduzido ao
+// intervalo [0, MAX_MATRIX_VALUE) por multiplicacao (sem divisao, para que a varredura vetorize)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <omp.h>
+
+#include "jacobiregen.h"
+
+#define DOURADO 0x9e3779b9u // 2^32 / razao aurea: espalha contadores consecutivos
+
+// Finalizador do MurmurHash3: bijecao de 32 bits com boa avalanche
+static inline uint32_t mix32(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Chave da linha i do sistema gerado com 'semente'
+static inline uint32_t row_key(uint32_t semente, int i)
+{
+    return mix32(mix32(semente) + (uint32_t)i * DOURADO);
+}
+
+// Valor inteiro em [0, maximo) da coluna j da linha de chave 'chave' (a coluna N guarda o vetor B)
+static inline double element(uint32_t chave, int j, uint32_t maximo)
+{
+    uint32_t h = mix32(chave ^ ((uint32_t)j * DOURADO));
+    return (double)(uint32_t)(((uint64_t)h * maximo) >> 32);
+}
+
+// Diagonal e vetor B do sistema, como em init_matrix: se a linha nao eh diagonalmente dominante, a
+// diagonal passa a ser a soma da linha + 1. Guarda a diagonal em vet_diag e B normalizado em vet_b e usa
+// B normalizado como chute inicial. Custa uma varredura, depois da qual nada da matriz fica na memoria
+void regen_init(jacobi_gerador *gerador, jacobi_contexto *ctx, int seed)
+{
+    int N = ctx->N;
+
+    gerador->semente = (uint32_t)seed;
+    gerador->N = N;
+
+#pragma omp parallel for num_threads(ctx->T) schedule(static)
+    for (int i = 0; i < N; i++)
+    {
+        uint32_t chave = row_key(gerador->semente, i);
+        double soma_linha = 0;
+#pragma omp simd reduction(+ : soma_linha)
+        for (int j = 0; j < N; j++)
+        {
+            soma_linha += element(chave, j, MAX_MATRIX_VALUE);
+        }
+
+        double diag = element(chave, i, MAX_MATRIX_VALUE);
+        if (diag < soma_linha - diag)
+        {
+            diag = soma_linha + 1;
+        }
+        ctx->vet_diag[i] = diag;
+        ctx->vet_b[i] = element(chave, N, MAX_B_VALUE) / diag;
+    }
+
+    jacobi_set_initial_guess(ctx, ctx->vet_b);
+}
+
+// Uma varredura com as linhas recalculadas: vet_soma[i] = B*[i] - (sum_j a_ij.x[j] - a_ii.x[i]) / diag[i].
+// A linha original eh acumulada inteira e normalizada uma vez no fim, em vez de elemento a elemento
+void regen_sweep(const jacobi_gerador *gerador, const double *vet_b, const double *vet_diag, const double *vet_x,
+                 double *vet_soma, int T)
+{
+    int N = gerador->N;
+
+#pragma omp parallel for num_threads(T) schedule(static)
+    for (int i = 0; i < N; i++)
+    {
+        uint32_t chave = row_key(gerador->semente, i);
+        double produto = 0;
+#pragma omp simd reduction(+ : produto)
+        for (int j = 0; j < N; j++)
+        {
+            produto += element(chave, j, MAX_MATRIX_VALUE) * vet_x[j];
+        }
+        produto -= element(chave, i, MAX_MATRIX_VALUE) * vet_x[i]; // a diagonal normalizada eh zero
+        vet_soma[i] = vet_b[i] - produto / vet_diag[i];
+    }
+}
+
+// Equivalente de calculate_new_x com a matriz regenerada a cada varredura
+void regen_new_x(const jacobi_gerador *gerador, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x,
+                 double *residuo, int N, int T)
+{
+    double res_max = 0;
+    double res_quad = 0;
+
+#pragma omp parallel for simd num_threads(T)
+    for (int i = 0; i < N; i++)
+    {
+        vet_x[i] = vet_new_x[i]; // vetor X recebe o novo vetor X (proximo chute)
+    }
+
+    regen_sweep(gerador, vet_b, vet_diag, vet_x, vet_new_x, T);
+
+    // Residuo do sistema original no vetor X atual, como em calculate_new_x
+#pragma omp parallel for simd num_threads(T) reduction(max : res_max) reduction(+ : res_quad)
+    for (int i = 0; i < N; i++)
+    {
+        double r = vet_diag[i] * (vet_new_x[i] - vet_x[i]);
+        res_max = fmax(res_max, fabs(r));
+        res_quad += r * r;
+    }
+    residuo[0] = res_max;
+    residuo[1] = res_quad;
+}
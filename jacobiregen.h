@@ -0,0 +1,28 @@
+// Modo de regeneracao: a matriz nao eh armazenada. Cada elemento a_ij eh uma funcao pura de (seed, i, j)
+// (gerador baseado em contador), de modo que cada varredura recalcula as linhas em vez de le-las da
+// memoria, com a normalizacao pela diagonal aplicada na propria varredura. Troca o teto de banda da DRAM
+// por aritmetica e permite ordens muito alem da memoria (o sistema gerado difere do de init_matrix, que
+// usa rand())
+
+#ifndef JACOBIREGEN_H
+#define JACOBIREGEN_H
+
+#include <stdint.h>
+
+#include "jacobipar.h"
+
+#define MAX_B_VALUE 100 // elementos de B em [0, MAX_B_VALUE), como em init_matrix
+
+typedef struct jacobi_gerador
+{
+    uint32_t semente; // seed do sistema
+    int N;            // ordem da matriz
+} jacobi_gerador;
+
+void regen_init(jacobi_gerador *gerador, jacobi_contexto *ctx, int seed);
+void regen_sweep(const jacobi_gerador *gerador, const double *vet_b, const double *vet_diag, const double *vet_x,
+                 double *vet_soma, int T);
+void regen_new_x(const jacobi_gerador *gerador, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x,
+                 double *residuo, int N, int T);
+
+#endif
@@ -0,0 +1,178 @@
+// Servidor de resolucoes sobre um socket Unix (um pedido por vez: cada resolucao ja usa todas as threads)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+
+#include "jacobiserv.h"
+
+// Confere os parametros de um pedido de resolucao (zero seleciona o valor do servidor)
+static int valid_request(const jacobi_pedido *pedido)
+{
+    return (pedido->flags & ~(uint32_t)(PEDIDO_COM_B | PEDIDO_REINICIAR)) == 0 &&
+           (pedido->criterio & ~(uint32_t)CRITERIOS_VALIDOS) == 0 && pedido->tol >= 0 && pedido->tol < 1 &&
+           pedido->atol >= 0 && isfinite(pedido->atol) && pedido->max_iteracoes >= 0;
+}
+
+// Atende os pedidos de uma conexao ate o cliente fechar ou ficar TEMPO_OCIOSO segundos sem enviar dados.
+// Retorna 0 se foi pedido o encerramento
+static int serve_connection(int fd, jacobi_contexto *ctx, const jacobi_opcoes *padrao, double *vet_b, int *pedidos)
+{
+    int N = ctx->N;
+    jacobi_pedido pedido;
+
+    while (receive_all(fd, &pedido, sizeof(pedido)))
+    {
+        jacobi_resposta resposta;
+        memset(&resposta, 0, sizeof(resposta));
+        memcpy(resposta.magica, MAGICA_RESPOSTA, sizeof(resposta.magica));
+        resposta.N = N;
+
+        if (memcmp(pedido.magica, MAGICA_PEDIDO, sizeof(pedido.magica)) != 0 || pedido.versao != VERSAO_PROTOCOLO)
+        {
+            return 1; // nao eh um cliente deste protocolo: fecha a conexao
+        }
+        if (pedido.operacao == PEDIDO_ENCERRAR)
+        {
+            send_all(fd, &resposta, sizeof(resposta));
+            return 0;
+        }
+        if (pedido.operacao != PEDIDO_RESOLVER || pedido.N != N || !valid_request(&pedido))
+        {
+            // Informacao, pedido para outra ordem ou com parametros invalidos: so o cabecalho (o B enviado
+            // eh descartado)
+            resposta.status = pedido.operacao == PEDIDO_INFO ? JACOBI_CONVERGIU : RESPOSTA_INVALIDA;
+            if (pedido.operacao == PEDIDO_RESOLVER && (pedido.flags & PEDIDO_COM_B))
+            {
+                for (int64_t k = 0; k < pedido.N; k += N)
+                {
+                    int n = pedido.N - k < N ? (int)(pedido.N - k) : N;
+                    if (!receive_all(fd, vet_b, sizeof(double) * n))
+                    {
+                        return 1;
+                    }
+                }
+            }
+            if (!send_all(fd, &resposta, sizeof(resposta)))
+            {
+                return 1;
+            }
+            continue;
+        }
+
+        if (pedido.flags & PEDIDO_COM_B)
+        {
+            if (!receive_all(fd, vet_b, sizeof(double) * N))
+            {
+                return 1;
+            }
+            for (int i = 0; i < N; i++)
+            {
+                ctx->vet_b[i] = vet_b[i] / ctx->vet_diag[i];
+            }
+        }
+        if (pedido.flags & PEDIDO_REINICIAR)
+        {
+            jacobi_set_initial_guess(ctx, ctx->vet_b);
+        }
+
+        jacobi_opcoes opcoes = *padrao;
+        opcoes.criterio = pedido.criterio != 0 ? (int)pedido.criterio : opcoes.criterio;
+        opcoes.tol = pedido.tol > 0 ? pedido.tol : opcoes.tol;
+        opcoes.atol = pedido.atol > 0 ? pedido.atol : opcoes.atol;
+        opcoes.max_iteracoes = pedido.max_iteracoes > 0 ? pedido.max_iteracoes : opcoes.max_iteracoes;
+
+        resposta.status = jacobi_solve(ctx, &opcoes);
+        resposta.cont = ctx->cont;
+        resposta.error = ctx->error;
+        resposta.residuo_inf = ctx->residuo_inf;
+        resposta.residuo_2 = ctx->residuo_2;
+        resposta.tempo = ctx->tempo_iteracoes;
+        (*pedidos)++;
+        printf("Pedido %d: %d iteracoes em %.3f ms\n", *pedidos, ctx->cont, 1e3 * ctx->tempo_iteracoes);
+        fflush(stdout);
+
+        if (!send_all(fd, &resposta, sizeof(resposta)) || !send_all(fd, ctx->vet_x, sizeof(double) * N))
+        {
+            return 1;
+        }
+    }
+    return 1;
+}
+
+// Atende pedidos no socket Unix 'caminho' ate receber PEDIDO_ENCERRAR. padrao contem as opcoes usadas
+// quando o pedido nao as informa. Cada resolucao parte da solucao anterior (salvo PEDIDO_REINICIAR)
+void serve(jacobi_contexto *ctx, const jacobi_opcoes *padrao, const char *caminho)
+{
+    struct sockaddr_un endereco;
+    int pedidos = 0;
+
+    if (strlen(caminho) >= sizeof(endereco.sun_path))
+    {
+        printf("Caminho do socket muito longo: %s\n", caminho);
+        exit(1);
+    }
+    memset(&endereco, 0, sizeof(endereco));
+    endereco.sun_family = AF_UNIX;
+    strcpy(endereco.sun_path, caminho);
+
+    int servidor = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(caminho); // socket deixado por um servidor anterior
+    if (servidor < 0 || bind(servidor, (struct sockaddr *)&endereco, sizeof(endereco)) != 0 ||
+        listen(servidor, FILA_SERVIDOR) != 0)
+    {
+        printf("Erro ao criar o socket %s\n", caminho);
+        exit(1);
+    }
+    signal(SIGPIPE, SIG_IGN); // cliente que fecha a conexao no meio da resposta nao derruba o servidor
+
+    double *vet_b = (double *)alloc_aligned(sizeof(double) * ctx->N);
+    if (vet_b == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+
+    printf("Servindo o sistema de ordem %d em %s\n", ctx->N, caminho);
+    fflush(stdout);
+    int continuar = 1;
+    while (continuar)
+    {
+        int conexao = accept(servidor, NULL, NULL);
+        if (conexao < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM)
+            {
+                printf("Erro ao aceitar conexao (%s): aguardando\n", strerror(errno));
+                fflush(stdout);
+                sleep(1); // falta de recursos passageira: evita girar no accept
+                continue;
+            }
+            printf("Erro ao aceitar conexao: %s\n", strerror(errno));
+            exit(1);
+        }
+
+        // Um cliente ocioso nao bloqueia os demais: leituras e escritas expiram apos TEMPO_OCIOSO
+        struct timeval limite = {TEMPO_OCIOSO, 0};
+        setsockopt(conexao, SOL_SOCKET, SO_RCVTIMEO, &limite, sizeof(limite));
+        setsockopt(conexao, SOL_SOCKET, SO_SNDTIMEO, &limite, sizeof(limite));
+        continuar = serve_connection(conexao, ctx, padrao, vet_b, &pedidos);
+        close(conexao);
+    }
+
+    free_aligned(vet_b);
+    close(servidor);
+    unlink(caminho);
+    printf("Servidor encerrado apos %d pedido(s)\n", pedidos);
+}
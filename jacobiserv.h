@@ -0,0 +1,94 @@
+// Modo servidor: o sistema eh montado uma vez (gerado, lido, comprimido...) e fica na memoria, e pedidos
+// de resolucao chegam por um socket Unix. Cada pedido traz opcionalmente um novo vetor B e as tolerancias
+// e recebe o vetor X, de modo que a latencia de cada resolucao eh so o tempo das iteracoes. O protocolo
+// (structs abaixo, na ordem de bytes da maquina) tambem eh usado pelo cliente jacobicli
+
+#ifndef JACOBISERV_H
+#define JACOBISERV_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <unistd.h>
+
+#include "jacobipar.h"
+
+#define MAGICA_PEDIDO "JACOBIP"
+#define MAGICA_RESPOSTA "JACOBIR"
+#define VERSAO_PROTOCOLO 1
+#define FILA_SERVIDOR 16 // conexoes aguardando accept
+#define TEMPO_OCIOSO 10   // segundos sem dados apos os quais o servidor fecha a conexao
+
+// Operacoes de um pedido
+#define PEDIDO_RESOLVER 0  // resolve (com o novo B, se enviado) e devolve X
+#define PEDIDO_INFO 1      // devolve somente a ordem do sistema (resposta com N e sem X)
+#define PEDIDO_ENCERRAR 2  // encerra o servidor
+
+// Flags de um pedido de resolucao
+#define PEDIDO_COM_B 1     // N valores do vetor B original seguem o pedido
+#define PEDIDO_REINICIAR 2 // chute inicial B* em vez da solucao anterior (warm start)
+
+#define RESPOSTA_INVALIDA -1 // status de um pedido rejeitado (ordem, flags, criterio ou tolerancias invalidos)
+
+typedef struct
+{
+    char magica[8];        // MAGICA_PEDIDO
+    uint32_t versao;       // VERSAO_PROTOCOLO
+    uint32_t operacao;     // PEDIDO_*
+    uint32_t flags;        // PEDIDO_COM_B, PEDIDO_REINICIAR
+    uint32_t criterio;     // CRITERIO_* (0: o do servidor)
+    double tol;            // 0: a do servidor
+    double atol;           // 0: a do servidor
+    int32_t max_iteracoes; // 0: o do servidor
+    int32_t reservado;
+    int64_t N;             // ordem do sistema esperada pelo cliente (0 em PEDIDO_INFO)
+} jacobi_pedido;
+
+typedef struct
+{
+    char magica[8];     // MAGICA_RESPOSTA
+    int32_t status;     // JACOBI_* ou RESPOSTA_INVALIDA
+    int32_t cont;       // iteracoes
+    double error;       // erro da ultima iteracao
+    double residuo_inf; // |b - Ax|inf do penultimo X
+    double residuo_2;   // |b - Ax|2 do penultimo X
+    double tempo;       // segundos das iteracoes
+    int64_t N;          // ordem do sistema; N valores de X seguem a resposta de uma resolucao
+} jacobi_resposta;
+
+// Le ou escreve exatamente 'bytes' bytes (o socket pode transferir menos por chamada). Retorna 0 se a
+// conexao terminou, falhou ou ficou ociosa alem do tempo limite
+static inline int receive_all(int fd, void *destino, size_t bytes)
+{
+    char *p = (char *)destino;
+    while (bytes > 0)
+    {
+        ssize_t n = read(fd, p, bytes);
+        if (n <= 0)
+        {
+            return 0;
+        }
+        p += n;
+        bytes -= n;
+    }
+    return 1;
+}
+
+static inline int send_all(int fd, const void *origem, size_t bytes)
+{
+    const char *p = (const char *)origem;
+    while (bytes > 0)
+    {
+        ssize_t n = write(fd, p, bytes);
+        if (n <= 0)
+        {
+            return 0;
+        }
+        p += n;
+        bytes -= n;
+    }
+    return 1;
+}
+
+void serve(jacobi_contexto *ctx, const jacobi_opcoes *padrao, const char *caminho);
+
+#endif
@@ -0,0 +1,201 @@
+// Matriz simetrica em blocos do triangulo superior e varredura que aplica cada bloco duas vezes
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <omp.h>
+
+#include "jacobisim.h"
+
+#define TAMANHO_BLOCO (BLOCO_SIMETRICO * BLOCO_SIMETRICO)
+
+// Posicao do bloco (I, J), I <= J, no vetor de blocos
+static inline size_t block_index(int nb, int I, int J)
+{
+    return ((size_t)I * nb - (size_t)I * (I - 1) / 2 + (J - I)) * TAMANHO_BLOCO;
+}
+
+// Monta os blocos a partir da matriz normalizada de ctx (a_ij = A*[i j] * diag[i]) e confere a simetria.
+// Retorna 0, sem alocar nada, se a matriz original nao eh simetrica
+int symmetric_init(jacobi_simetrica *sim, const jacobi_contexto *ctx)
+{
+    int N = ctx->N;
+    int ld = ctx->ld;
+    const double *matrix = ctx->matrix;
+    const double *vet_diag = ctx->vet_diag;
+    int simetrica = 1;
+
+#pragma omp parallel for num_threads(ctx->T) schedule(dynamic, 16) reduction(& : simetrica)
+    for (int i = 0; i < N; i++)
+    {
+        for (int j = i + 1; j < N; j++)
+        {
+            double a_ij = matrix[(size_t)i * ld + j] * vet_diag[i];
+            double a_ji = matrix[(size_t)j * ld + i] * vet_diag[j];
+            simetrica &= fabs(a_ij - a_ji) <= TOLERANCIA_SIMETRIA * fmax(fabs(a_ij), fabs(a_ji));
+        }
+    }
+    if (!simetrica)
+    {
+        return 0;
+    }
+
+    memset(sim, 0, sizeof(*sim));
+    sim->N = N;
+    sim->nb = (N + BLOCO_SIMETRICO - 1) / BLOCO_SIMETRICO;
+    sim->Np = sim->nb * BLOCO_SIMETRICO;
+    sim->T = ctx->T;
+    sim->bytes = sizeof(double) * TAMANHO_BLOCO * ((size_t)sim->nb * (sim->nb + 1) / 2);
+    sim->blocos = (double *)alloc_aligned(sim->bytes);
+    sim->vet_x = (double *)alloc_aligned(sizeof(double) * sim->Np);
+    sim->parciais = (double *)alloc_aligned(sizeof(double) * sim->Np * sim->T);
+    if (sim->blocos == NULL || sim->vet_x == NULL || sim->parciais == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+    memset(sim->vet_x, 0, sizeof(double) * sim->Np);
+    memset(sim->parciais, 0, sizeof(double) * sim->Np * sim->T);
+
+    // Valores originais fora da diagonal; a diagonal e o preenchimento ficam zerados
+#pragma omp parallel for num_threads(ctx->T) schedule(dynamic, 1)
+    for (int I = 0; I < sim->nb; I++)
+    {
+        for (int J = I; J < sim->nb; J++)
+        {
+            double *bloco = sim->blocos + block_index(sim->nb, I, J);
+            for (int r = 0; r < BLOCO_SIMETRICO; r++)
+            {
+                int i = I * BLOCO_SIMETRICO + r;
+                for (int c = 0; c < BLOCO_SIMETRICO; c++)
+                {
+                    int j = J * BLOCO_SIMETRICO + c;
+                    bloco[r * BLOCO_SIMETRICO + c] = i < N && j < N && i != j ? matrix[(size_t)i * ld + j] * vet_diag[i] : 0;
+                }
+            }
+        }
+    }
+    return 1;
+}
+
+void symmetric_free(jacobi_simetrica *sim)
+{
+    free_aligned(sim->blocos);
+    free_aligned(sim->vet_x);
+    free_aligned(sim->parciais);
+}
+
+// Uma varredura: vet_soma[i] = B*[i] - (sum_j a_ij.x[j]) / diag[i]. Cada thread acumula as contribuicoes
+// dos seus blocos (linha e coluna) na sua soma parcial; as parciais sao somadas e zeradas no fim
+void symmetric_sweep(jacobi_simetrica *sim, const double *vet_b, const double *vet_diag, const double *vet_x,
+                     double *vet_soma)
+{
+    int N = sim->N;
+    int nb = sim->nb;
+    double *x = sim->vet_x;
+
+#pragma omp parallel num_threads(sim->T)
+    {
+        double *y = sim->parciais + (size_t)omp_get_thread_num() * sim->Np;
+
+#pragma omp for simd
+        for (int i = 0; i < N; i++)
+        {
+            x[i] = vet_x[i];
+        }
+
+        // Linhas da grade com numero decrescente de blocos: distribuicao dinamica
+#pragma omp for schedule(dynamic, 1)
+        for (int I = 0; I < nb; I++)
+        {
+            double *y_I = y + I * BLOCO_SIMETRICO;
+            const double *x_I = x + I * BLOCO_SIMETRICO;
+
+            for (int J = I; J < nb; J++)
+            {
+                const double *bloco = sim->blocos + block_index(nb, I, J);
+                double *y_J = y + J * BLOCO_SIMETRICO;
+                const double *x_J = x + J * BLOCO_SIMETRICO;
+
+                if (J == I)
+                {
+                    // Bloco da diagonal: guardado inteiro, aplicado uma vez
+                    for (int r = 0; r < BLOCO_SIMETRICO; r++)
+                    {
+                        double acc = 0;
+#pragma omp simd reduction(+ : acc)
+                        for (int c = 0; c < BLOCO_SIMETRICO; c++)
+                        {
+                            acc += bloco[r * BLOCO_SIMETRICO + c] * x_J[c];
+                        }
+                        y_I[r] += acc;
+                    }
+                    continue;
+                }
+
+                // Cada valor lido do bloco serve a linha r de I e a coluna c de J
+                for (int r = 0; r < BLOCO_SIMETRICO; r++)
+                {
+                    double acc = 0;
+                    double x_r = x_I[r];
+#pragma omp simd reduction(+ : acc)
+                    for (int c = 0; c < BLOCO_SIMETRICO; c++)
+                    {
+                        double a = bloco[r * BLOCO_SIMETRICO + c];
+                        acc += a * x_J[c];
+                        y_J[c] += a * x_r;
+                    }
+                    y_I[r] += acc;
+                }
+            }
+        }
+
+        // Soma das parciais (e zera para a proxima varredura) e normalizacao pela diagonal
+#pragma omp for
+        for (int i = 0; i < N; i++)
+        {
+            double soma = 0;
+            for (int t = 0; t < sim->T; t++)
+            {
+                soma += sim->parciais[(size_t)t * sim->Np + i];
+                sim->parciais[(size_t)t * sim->Np + i] = 0;
+            }
+            vet_soma[i] = vet_b[i] - soma / vet_diag[i];
+        }
+    }
+}
+
+// Equivalente de calculate_new_x com a matriz simetrica
+void symmetric_new_x(jacobi_simetrica *sim, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x,
+                     double *residuo, int N, int T)
+{
+    double res_max = 0;
+    double res_quad = 0;
+
+#pragma omp parallel for simd num_threads(T)
+    for (int i = 0; i < N; i++)
+    {
+        vet_x[i] = vet_new_x[i]; // vetor X recebe o novo vetor X (proximo chute)
+    }
+
+    symmetric_sweep(sim, vet_b, vet_diag, vet_x, vet_new_x);
+
+    // Residuo do sistema original no vetor X atual, como em calculate_new_x
+#pragma omp parallel for simd num_threads(T) reduction(max : res_max) reduction(+ : res_quad)
+    for (int i = 0; i < N; i++)
+    {
+        double r = vet_diag[i] * (vet_new_x[i] - vet_x[i]);
+        res_max = fmax(res_max, fabs(r));
+        res_quad += r * r;
+    }
+    residuo[0] = res_max;
+    residuo[1] = res_quad;
+}
+
+void symmetric_report(const jacobi_simetrica *sim, FILE *arq)
+{
+    double densa = sizeof(double) * (double)sim->N * sim->N;
+    fprintf(arq, "Matriz simetrica: %d x %d blocos de %d (triangulo superior), %.1f MiB (%.1f%% da densa)\n", sim->nb,
+            sim->nb, BLOCO_SIMETRICO, sim->bytes / 1048576.0, 100 * sim->bytes / densa);
+}
@@ -0,0 +1,38 @@
+// Armazenamento simetrico: quando a matriz original eh simetrica, somente os blocos (I, J) com I <= J de
+// uma grade de BLOCO_SIMETRICO x BLOCO_SIMETRICO sao guardados, com os valores originais (sem
+// normalizacao). A varredura le cada bloco uma vez e o aplica a linha I (y_I += B.x_J) e, transposto, a
+// linha J (y_J += B^T.x_I); a normalizacao entra no fim: novo x[i] = B*[i] - y[i] / diag[i]. A memoria e
+// os bytes lidos por iteracao caem aproximadamente pela metade
+
+#ifndef JACOBISIM_H
+#define JACOBISIM_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+#include "jacobipar.h"
+
+#define BLOCO_SIMETRICO 64        // ordem dos blocos (32 KiB por bloco)
+#define TOLERANCIA_SIMETRIA 1e-12 // diferenca relativa maxima entre a_ij e a_ji
+
+typedef struct jacobi_simetrica
+{
+    int N;
+    int Np;            // N arredondado para blocos inteiros
+    int nb;            // blocos por linha da grade
+    int T;             // threads da varredura (uma soma parcial de y por thread)
+    double *blocos;    // blocos (I, J), I <= J, linha a linha da grade, cada um com BLOCO_SIMETRICO^2 valores
+    double *vet_x;     // vetor X com Np elementos (preenchimento zerado)
+    double *parciais;  // T vetores de Np somas parciais de y = A.x (sem a diagonal)
+    size_t bytes;      // memoria dos blocos
+} jacobi_simetrica;
+
+int symmetric_init(jacobi_simetrica *sim, const jacobi_contexto *ctx);
+void symmetric_free(jacobi_simetrica *sim);
+void symmetric_sweep(jacobi_simetrica *sim, const double *vet_b, const double *vet_diag, const double *vet_x,
+                     double *vet_soma);
+void symmetric_new_x(jacobi_simetrica *sim, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x,
+                     double *residuo, int N, int T);
+void symmetric_report(const jacobi_simetrica *sim, FILE *arq);
+
+#endif
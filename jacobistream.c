@@ -0,0 +1,270 @@
+// Varredura da matriz lida do disco em paineis, com leitura antecipada em buffer duplo
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <omp.h>
+
+#include "jacobistream.h"
+#include "jacobitrace.h"
+#include "jacobiafin.h"
+
+// Le 'bytes' do arquivo a partir de 'deslocamento' (pread pode ler menos que o pedido). Retorna 0 se falhar
+static int read_panel(int fd, char *destino, size_t bytes, off_t deslocamento)
+{
+    while (bytes > 0)
+    {
+        ssize_t lidos = pread(fd, destino, bytes, deslocamento);
+        if (lidos <= 0)
+        {
+            return 0;
+        }
+        destino += lidos;
+        bytes -= lidos;
+        deslocamento += lidos;
+    }
+    return 1;
+}
+
+// Thread de leitura: enche os buffers com os paineis na ordem das varreduras (0, 1, ..., P-1, 0, ...),
+// esperando a varredura liberar o buffer antes de reutiliza-lo
+static void *read_ahead(void *arg)
+{
+    jacobi_fluxo *fluxo = (jacobi_fluxo *)arg;
+    size_t bytes_linha = sizeof(double) * fluxo->ld;
+
+    for (long k = 0;; k++)
+    {
+        int b = k % BUFFERS_PAINEL;
+        pthread_mutex_lock(&fluxo->trava);
+        while (fluxo->pronto[b] && !fluxo->parar)
+        {
+            pthread_cond_wait(&fluxo->mudou, &fluxo->trava);
+        }
+        int parar = fluxo->parar;
+        pthread_mutex_unlock(&fluxo->trava);
+        if (parar)
+        {
+            break;
+        }
+
+        int p = k % fluxo->num_paineis;
+        int i0 = p * fluxo->linhas_painel;
+        int linhas = i0 + fluxo->linhas_painel <= fluxo->N ? fluxo->linhas_painel : fluxo->N - i0;
+        off_t inicio = fluxo->deslocamento + (off_t)i0 * bytes_linha;
+        size_t bytes = linhas * bytes_linha;
+
+        double t0 = omp_get_wtime();
+        int ok = read_panel(fluxo->fd, (char *)fluxo->painel[b], bytes, inicio);
+        if (ok && fluxo->descartar)
+        {
+            posix_fadvise(fluxo->fd, inicio, bytes, POSIX_FADV_DONTNEED);
+        }
+        double t1 = omp_get_wtime();
+
+        pthread_mutex_lock(&fluxo->trava);
+        fluxo->bytes_lidos += bytes;
+        fluxo->tempo_leitura += t1 - t0;
+        fluxo->erro |= !ok;
+        fluxo->pronto[b] = 1;
+        pthread_cond_broadcast(&fluxo->mudou);
+        pthread_mutex_unlock(&fluxo->trava);
+        if (!ok)
+        {
+            break;
+        }
+    }
+    return NULL;
+}
+
+// Prepara a leitura da matriz da imagem normalizada aberta em fd (ver jacobi_open_normalized) em paineis
+// de ate bytes_painel bytes e inicia a thread de leitura. O fluxo passa a ser dono de fd
+void stream_init(jacobi_fluxo *fluxo, int fd, const jacobi_imagem *img, size_t bytes_painel)
+{
+    size_t bytes_linha = sizeof(double) * img->ld;
+
+    memset(fluxo, 0, sizeof(*fluxo));
+    fluxo->fd = fd;
+    fluxo->deslocamento = (off_t)img->deslocamento_matriz;
+    fluxo->N = (int)img->N;
+    fluxo->ld = (int)img->ld;
+    fluxo->linhas_painel = bytes_painel / bytes_linha > 0 ? (int)(bytes_painel / bytes_linha) : 1;
+    if (fluxo->linhas_painel > fluxo->N)
+    {
+        fluxo->linhas_painel = fluxo->N;
+    }
+    fluxo->num_paineis = (fluxo->N + fluxo->linhas_painel - 1) / fluxo->linhas_painel;
+
+    // Matriz que cabe no cache de paginas: as varreduras seguintes leem da memoria. Maior que isso: o
+    // painel lido sai do cache, que de todo modo nao guardaria a matriz inteira
+    double memoria = (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+    fluxo->descartar = img->bytes_matriz >= memoria / 2;
+    posix_fadvise(fd, fluxo->deslocamento, img->bytes_matriz, POSIX_FADV_SEQUENTIAL);
+
+    for (int b = 0; b < BUFFERS_PAINEL; b++)
+    {
+        fluxo->painel[b] = (double *)alloc_aligned(fluxo->linhas_painel * bytes_linha);
+        if (fluxo->painel[b] == NULL)
+        {
+            printf("Erro de alocação de memória\n");
+            exit(1);
+        }
+    }
+
+    pthread_mutex_init(&fluxo->trava, NULL);
+    pthread_cond_init(&fluxo->mudou, NULL);
+    pthread_attr_t atributos;
+    helper_thread_attr(&atributos); // mascara original, nao a cpu da thread mestre
+    if (pthread_create(&fluxo->leitor, &atributos, read_ahead, fluxo) != 0)
+    {
+        printf("Erro ao criar a thread de leitura\n");
+        exit(1);
+    }
+    pthread_attr_destroy(&atributos);
+}
+
+void stream_free(jacobi_fluxo *fluxo)
+{
+    pthread_mutex_lock(&fluxo->trava);
+    fluxo->parar = 1;
+    pthread_cond_broadcast(&fluxo->mudou);
+    pthread_mutex_unlock(&fluxo->trava);
+    pthread_join(fluxo->leitor, NULL);
+
+    pthread_mutex_destroy(&fluxo->trava);
+    pthread_cond_destroy(&fluxo->mudou);
+    for (int b = 0; b < BUFFERS_PAINEL; b++)
+    {
+        free_aligned(fluxo->painel[b]);
+    }
+    close(fluxo->fd);
+}
+
+// Espera o painel do buffer b
+static const double *wait_panel(jacobi_fluxo *fluxo, int b)
+{
+    double t0 = omp_get_wtime();
+
+    pthread_mutex_lock(&fluxo->trava);
+    while (!fluxo->pronto[b])
+    {
+        pthread_cond_wait(&fluxo->mudou, &fluxo->trava);
+    }
+    int erro = fluxo->erro;
+    pthread_mutex_unlock(&fluxo->trava);
+
+    fluxo->tempo_espera += omp_get_wtime() - t0;
+    if (erro)
+    {
+        printf("Erro ao ler a matriz do disco\n");
+        exit(1);
+    }
+    return fluxo->painel[b];
+}
+
+// Devolve o buffer do painel usado para a thread de leitura
+static void release_panel(jacobi_fluxo *fluxo, int b)
+{
+    pthread_mutex_lock(&fluxo->trava);
+    fluxo->pronto[b] = 0;
+    fluxo->consumidos++;
+    pthread_cond_broadcast(&fluxo->mudou);
+    pthread_mutex_unlock(&fluxo->trava);
+}
+
+// Uma varredura completa da matriz: vet_soma[i] = B*[i] - A*[i j].x[j]. As threads calculam as linhas de
+// cada painel enquanto a thread de leitura enche o outro buffer
+void stream_sweep(jacobi_fluxo *fluxo, const double *vet_b, const double *vet_x, double *vet_soma, int T)
+{
+    int ld = fluxo->ld;
+    int N = fluxo->N;
+    long primeiro = fluxo->consumidos; // o painel p da varredura esta no buffer (primeiro + p) % 2
+
+#pragma omp parallel num_threads(T)
+    {
+        for (int p = 0; p < fluxo->num_paineis; p++)
+        {
+            int i0 = p * fluxo->linhas_painel;
+            int i1 = i0 + fluxo->linhas_painel < N ? i0 + fluxo->linhas_painel : N;
+            int b = (primeiro + p) % BUFFERS_PAINEL;
+            const double *painel;
+
+            TRACE_INICIO(t_barreira);
+#pragma omp single copyprivate(painel)
+            painel = wait_panel(fluxo, b);
+            TRACE_FIM(TRACE_BARREIRA, t_barreira);
+
+            TRACE_INICIO(t_varredura);
+#pragma omp for schedule(static)
+            for (int i = i0; i < i1; i++)
+            {
+                const double *linha = painel + (size_t)(i - i0) * ld;
+                double soma = vet_b[i];
+#pragma omp simd reduction(+ : soma)
+                for (int j = 0; j < N; j++)
+                {
+                    soma -= linha[j] * vet_x[j];
+                }
+                vet_soma[i] = soma;
+            }
+            TRACE_FIM(TRACE_VARREDURA, t_varredura);
+
+            // A barreira do laco garante que nenhuma thread ainda le o painel
+#pragma omp single nowait
+            release_panel(fluxo, b);
+        }
+    }
+}
+
+// Equivalente de calculate_new_x com a matriz lida do disco (sempre com a varredura por linhas e
+// agendamento estatico dentro de cada painel)
+void stream_new_x(jacobi_fluxo *fluxo, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x, double *residuo,
+                  int N, int T)
+{
+    double res_max = 0;
+    double res_quad = 0;
+
+#pragma omp parallel for simd num_threads(T)
+    for (int i = 0; i < N; i++)
+    {
+        vet_x[i] = vet_new_x[i]; // vetor X recebe o novo vetor X (proximo chute)
+    }
+
+    stream_sweep(fluxo, vet_b, vet_x, vet_new_x, T);
+
+    // Residuo do sistema original no vetor X atual, como em calculate_new_x
+#pragma omp parallel for simd num_threads(T) reduction(max : res_max) reduction(+ : res_quad)
+    for (int i = 0; i < N; i++)
+    {
+        double r = vet_diag[i] * (vet_new_x[i] - vet_x[i]);
+        res_max = fmax(res_max, fabs(r));
+        res_quad += r * r;
+    }
+    residuo[0] = res_max;
+    residuo[1] = res_quad;
+}
+
+// Configuracao dos paineis e, depois de alguma varredura, a vazao da leitura e a espera da varredura
+void stream_report(jacobi_fluxo *fluxo, FILE *arq)
+{
+    double mib_painel = sizeof(double) * (double)fluxo->ld * fluxo->linhas_painel / (1 << 20);
+    fprintf(arq, "Fora da memoria: %d painel(is) de %d linhas (%.1f MiB), %d buffers\n", fluxo->num_paineis,
+            fluxo->linhas_painel, mib_painel, BUFFERS_PAINEL);
+
+    // A thread de leitura continua ativa e atualiza as medidas sob a trava
+    pthread_mutex_lock(&fluxo->trava);
+    long consumidos = fluxo->consumidos;
+    double bytes_lidos = fluxo->bytes_lidos;
+    double tempo_leitura = fluxo->tempo_leitura;
+    double tempo_espera = fluxo->tempo_espera;
+    pthread_mutex_unlock(&fluxo->trava);
+
+    if (consumidos > 0)
+    {
+        fprintf(arq, "Leitura: %.3f GB em %.3f s (%.3f GB/s); varredura esperou %.3f s por paineis\n", bytes_lidos / 1e9,
+                tempo_leitura, tempo_leitura > 0 ? bytes_lidos / tempo_leitura / 1e9 : 0, tempo_espera);
+    }
+}
@@ -0,0 +1,49 @@
+// Modo fora da memoria: a matriz normalizada fica somente na imagem em disco e cada varredura a le em
+// paineis de linhas consecutivas. Uma thread de leitura antecipada (pread) enche um dos dois buffers de
+// painel enquanto o time OpenMP calcula sobre o outro, de modo que a leitura do disco se sobrepoe ao
+// calculo. A memoria usada pela matriz cai para dois paineis
+
+#ifndef JACOBISTREAM_H
+#define JACOBISTREAM_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "jacobipar.h"
+#include "jacobiio.h"
+
+#define PAINEL_PADRAO_MIB 64 // tamanho padrao de cada buffer de painel
+#define BUFFERS_PAINEL 2
+
+typedef struct jacobi_fluxo
+{
+    int fd;                            // imagem normalizada
+    off_t deslocamento;                // inicio da matriz no arquivo
+    int N;                             // ordem da matriz
+    int ld;                            // distancia entre linhas
+    int linhas_painel;                 // linhas por painel (o ultimo pode ter menos)
+    int num_paineis;                   // paineis por varredura
+    int descartar;                     // matriz maior que a memoria: descarta do cache as paginas ja lidas
+    double *painel[BUFFERS_PAINEL];    // buffers de painel
+    int pronto[BUFFERS_PAINEL];        // buffer cheio, aguardando a varredura
+    long consumidos;                   // paineis ja usados pelas varreduras (o proximo esta no buffer consumidos % 2)
+    int parar;                         // pede o fim da thread de leitura
+    int erro;                          // falha de leitura
+    pthread_t leitor;                  // thread de leitura antecipada
+    pthread_mutex_t trava;
+    pthread_cond_t mudou;              // sinaliza buffer cheio ou liberado
+    double bytes_lidos;                // totais da thread de leitura
+    double tempo_leitura;
+    double tempo_espera;               // tempo que a varredura esperou por paineis
+} jacobi_fluxo;
+
+void stream_init(jacobi_fluxo *fluxo, int fd, const jacobi_imagem *img, size_t bytes_painel);
+void stream_free(jacobi_fluxo *fluxo);
+void stream_sweep(jacobi_fluxo *fluxo, const double *vet_b, const double *vet_x, double *vet_soma, int T);
+void stream_new_x(jacobi_fluxo *fluxo, double *vet_b, double *vet_diag, double *vet_x, double *vet_new_x, double *residuo,
+                  int N, int T);
+void stream_report(jacobi_fluxo *fluxo, FILE *arq);
+
+#endif
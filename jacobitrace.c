@@ -0,0 +1,122 @@
+// Buffers circulares de eventos por thread e exportacao no formato Chrome trace (JSON)
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <omp.h>
+
+#include "jacobitrace.h"
+
+int trace_ativo = 0;
+int trace_iteracao = 0;
+
+const char *nome_tipos_trace[TRACE_NUM_TIPOS] = {"copia", "varredura", "reducao", "barreira", "erro", "iteracao"};
+
+// Evento registrado: trecho [inicio, fim] em segundos de omp_get_wtime
+typedef struct
+{
+    double inicio;
+    double fim;
+    int tipo;
+    int iteracao;
+} trace_evento;
+
+// Buffer de uma thread, alinhado para que threads vizinhas nao compartilhem a linha de cache do contador
+typedef struct
+{
+    trace_evento *eventos;
+    long total; // eventos registrados (o buffer guarda os ultimos 'capacidade')
+    char preenchimento[48];
+} trace_buffer;
+
+static trace_buffer buffers[TRACE_MAX_THREADS];
+static int num_threads_trace = 0;
+static int capacidade_trace = 0;
+static double origem; // instante zero da linha do tempo
+
+// Pre-aloca um buffer de 'capacidade' eventos para cada uma das T threads e habilita o rastreamento
+int trace_init(int T, int capacidade)
+{
+    if (T > TRACE_MAX_THREADS)
+    {
+        T = TRACE_MAX_THREADS;
+    }
+    num_threads_trace = T;
+    capacidade_trace = capacidade > 0 ? capacidade : TRACE_CAPACIDADE;
+
+    for (int t = 0; t < T; t++)
+    {
+        buffers[t].eventos = (trace_evento *)malloc(sizeof(trace_evento) * capacidade_trace);
+        buffers[t].total = 0;
+        if (buffers[t].eventos == NULL)
+        {
+            printf("Erro de alocação de memória\n");
+            exit(1);
+        }
+    }
+
+    origem = omp_get_wtime();
+    trace_iteracao = 0;
+    trace_ativo = 1;
+    return 1;
+}
+
+void trace_record(int tipo, double inicio)
+{
+    int t = omp_get_thread_num();
+    if (t >= num_threads_trace)
+    {
+        return;
+    }
+
+    trace_buffer *buffer = &buffers[t];
+    trace_evento *evento = &buffer->eventos[buffer->total % capacidade_trace];
+    evento->inicio = inicio;
+    evento->fim = omp_get_wtime();
+    evento->tipo = tipo;
+    evento->iteracao = trace_iteracao;
+    buffer->total++;
+}
+
+// Grava os eventos de todas as threads em nome_arq no formato Chrome trace ("X": evento completo, com
+// inicio e duracao em microssegundos). Retorna 0 se o arquivo nao pode ser aberto
+int trace_dump(const char *nome_arq)
+{
+    FILE *arq = fopen(nome_arq, "w");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        return 0;
+    }
+
+    fprintf(arq, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    fprintf(arq, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 0, \"args\": {\"name\": \"jacobipar\"}}");
+    for (int t = 0; t < num_threads_trace; t++)
+    {
+        fprintf(arq, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}", t, t);
+
+        trace_buffer *buffer = &buffers[t];
+        long primeiro = buffer->total > capacidade_trace ? buffer->total - capacidade_trace : 0;
+        for (long k = primeiro; k < buffer->total; k++)
+        {
+            trace_evento *evento = &buffer->eventos[k % capacidade_trace];
+            fprintf(arq, ",\n{\"name\": \"%s\", \"cat\": \"jacobi\", \"ph\": \"X\", \"pid\": 0, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"iteracao\": %d}}",
+                    nome_tipos_trace[evento->tipo], t, (evento->inicio - origem) * 1e6, (evento->fim - evento->inicio) * 1e6,
+                    evento->iteracao);
+        }
+    }
+    fprintf(arq, "\n]}\n");
+
+    fclose(arq);
+    return 1;
+}
+
+void trace_finish(void)
+{
+    trace_ativo = 0;
+    for (int t = 0; t < num_threads_trace; t++)
+    {
+        free(buffers[t].eventos);
+        buffers[t].eventos = NULL;
+    }
+    num_threads_trace = 0;
+}
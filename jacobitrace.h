@@ -0,0 +1,46 @@
+// Rastreamento leve da linha do tempo de cada thread (trechos da varredura, barreiras, reducoes),
+// gravado em um buffer circular pre-alocado por thread e exportado no formato Chrome trace (JSON),
+// que pode ser aberto no Perfetto (ui.perfetto.dev) ou em chrome://tracing.
+// Desabilitado, cada marcacao custa um teste; compilado com -DJACOBI_SEM_TRACE, nao custa nada
+
+#ifndef JACOBITRACE_H
+#define JACOBITRACE_H
+
+#include <omp.h>
+
+// Tipos de evento
+#define TRACE_COPIA 0     // copia de novo X para X (inicio de calculate_new_x)
+#define TRACE_VARREDURA 1 // trecho de linhas da varredura de calculate_new_x
+#define TRACE_REDUCAO 2   // combinacao das reducoes locais de cada thread
+#define TRACE_BARREIRA 3  // espera em barreira
+#define TRACE_ERRO 4      // trecho de calculate_error
+#define TRACE_ITERACAO 5  // uma iteracao completa (thread mestre)
+#define TRACE_NUM_TIPOS 6
+
+#define TRACE_CAPACIDADE (1 << 16) // eventos por thread no buffer circular
+#define TRACE_MAX_THREADS 256
+
+extern int trace_ativo;
+extern int trace_iteracao; // iteracao atual, registrada em cada evento
+
+#ifndef JACOBI_SEM_TRACE
+// Marca o inicio de um trecho na variavel local 'var'
+#define TRACE_INICIO(var) double var = trace_ativo ? omp_get_wtime() : 0
+// Registra o trecho [var, agora] do tipo 'tipo' na thread atual
+#define TRACE_FIM(tipo, var)                 \
+    do                                       \
+    {                                        \
+        if (trace_ativo)                     \
+            trace_record((tipo), (var));     \
+    } while (0)
+#else
+#define TRACE_INICIO(var) double var = 0
+#define TRACE_FIM(tipo, var) ((void)(var))
+#endif
+
+int trace_init(int T, int capacidade);
+void trace_record(int tipo, double inicio);
+int trace_dump(const char *nome_arq);
+void trace_finish(void);
+
+#endif
@@ -0,0 +1,263 @@
+// Autotuning da varredura e arquivo de configuracoes ajustadas. Cada linha do arquivo guarda a melhor
+// configuracao de um processador para as ordens N no intervalo [2^k, 2^(k+1)):
+// <cpu> <N_min> <N_max> <threads> <variante> <bloco_linhas> <bloco_colunas> <agendamento> <chunk>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <omp.h>
+
+#include "jacobitune.h"
+
+#define MAX_LINHAS_TUNING 1024
+
+// Modelo do processador (/proc/cpuinfo) com caracteres fora de [A-Za-z0-9] trocados por '_'
+void cpu_model(char *modelo, int tamanho)
+{
+    char linha[256];
+    snprintf(modelo, tamanho, "desconhecido");
+    FILE *arq = fopen("/proc/cpuinfo", "r");
+    if (arq == NULL)
+    {
+        return;
+    }
+    while (fgets(linha, sizeof(linha), arq) != NULL)
+    {
+        char *valor = strchr(linha, ':');
+        if (strncmp(linha, "model name", 10) == 0 && valor != NULL)
+        {
+            valor += 2;
+            int k = 0;
+            for (; valor[k] != '\0' && valor[k] != '\n' && k < tamanho - 1; k++)
+            {
+                char c = valor[k];
+                int valido = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+                modelo[k] = valido ? c : '_';
+            }
+            modelo[k] = '\0';
+            break;
+        }
+    }
+    fclose(arq);
+}
+
+const char *tune_file(void)
+{
+    const char *nome_arq = getenv("JACOBI_TUNING");
+    return nome_arq != NULL ? nome_arq : ARQUIVO_TUNING;
+}
+
+// Intervalo de ordens [2^k, 2^(k+1)) que contem N
+static void n_range(int N, int *n_min, int *n_max)
+{
+    int k = 1;
+    while (k * 2 <= N)
+    {
+        k *= 2;
+    }
+    *n_min = k;
+    *n_max = 2 * k - 1;
+}
+
+// Campos de uma linha do arquivo de tuning dentro dos limites aceitos pela varredura (o arquivo pode ter
+// sido editado a mao ou gravado por outra versao)
+static int valid_entry(int threads, int variante, int bloco_linhas, int bloco_colunas, int agendamento, int chunk)
+{
+    return threads >= 1 && threads <= omp_get_thread_limit() && (variante == KERNEL_LINHAS || variante == KERNEL_BLOCOS) &&
+           bloco_linhas >= 1 && bloco_linhas <= MAX_BLOCO_LINHAS && bloco_colunas >= 0 &&
+           agendamento >= omp_sched_static && agendamento <= omp_sched_auto && chunk >= 0;
+}
+
+// Procura a configuracao ajustada para este processador e a faixa de N. Linhas com campos fora dos
+// limites sao ignoradas. Retorna 1 se encontrada
+int tune_lookup(const char *nome_arq, int N, jacobi_kernel *kernel, int *T)
+{
+    char modelo[128];
+    char linha[512];
+    char cpu[128];
+    int n_min, n_max, threads, variante, bloco_linhas, bloco_colunas, agendamento, chunk;
+    int encontrada = 0;
+
+    FILE *arq = fopen(nome_arq, "r");
+    if (arq == NULL)
+    {
+        return 0;
+    }
+    cpu_model(modelo, sizeof(modelo));
+
+    while (fgets(linha, sizeof(linha), arq) != NULL)
+    {
+        if (linha[0] == '#' ||
+            sscanf(linha, "%127s %d %d %d %d %d %d %d %d", cpu, &n_min, &n_max, &threads, &variante, &bloco_linhas,
+                   &bloco_colunas, &agendamento, &chunk) != 9)
+        {
+            continue;
+        }
+        if (strcmp(cpu, modelo) == 0 && N >= n_min && N <= n_max &&
+            valid_entry(threads, variante, bloco_linhas, bloco_colunas, agendamento, chunk))
+        {
+            kernel->variante = variante;
+            kernel->bloco_linhas = bloco_linhas;
+            kernel->bloco_colunas = bloco_colunas;
+            kernel->agendamento = (omp_sched_t)agendamento;
+            kernel->chunk = chunk;
+            *T = threads;
+            encontrada = 1;
+        }
+    }
+
+    fclose(arq);
+    return encontrada;
+}
+
+// Grava (ou substitui) a configuracao deste processador para a faixa de N. Retorna 0 em caso de erro
+int tune_save(const char *nome_arq, int N, const jacobi_kernel *kernel, int T)
+{
+    static char linhas[MAX_LINHAS_TUNING][512];
+    char modelo[128];
+    char cpu[128];
+    int num_linhas = 0;
+    int n_min, n_max, linha_min;
+
+    cpu_model(modelo, sizeof(modelo));
+    n_range(N, &n_min, &n_max);
+
+    // Mantem as linhas dos outros processadores e faixas
+    FILE *arq = fopen(nome_arq, "r");
+    if (arq != NULL)
+    {
+        while (num_linhas < MAX_LINHAS_TUNING && fgets(linhas[num_linhas], sizeof(linhas[0]), arq) != NULL)
+        {
+            if (linhas[num_linhas][0] == '#' ||
+                (sscanf(linhas[num_linhas], "%127s %d", cpu, &linha_min) == 2 && strcmp(cpu, modelo) == 0 && linha_min == n_min))
+            {
+                continue;
+            }
+            num_linhas++;
+        }
+        fclose(arq);
+    }
+
+    arq = fopen(nome_arq, "w");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        return 0;
+    }
+    fprintf(arq, "# cpu N_min N_max threads variante bloco_linhas bloco_colunas agendamento chunk\n");
+    for (int l = 0; l < num_linhas; l++)
+    {
+        fputs(linhas[l], arq);
+    }
+    fprintf(arq, "%s %d %d %d %d %d %d %d %d\n", modelo, n_min, n_max, T, kernel->variante, kernel->bloco_linhas,
+            kernel->bloco_colunas, (int)kernel->agendamento, kernel->chunk);
+
+    fclose(arq);
+    return 1;
+}
+
+// Menor tempo por iteracao (varredura + erro) entre AMOSTRAS_TUNING amostras de ITERACOES_TUNING iteracoes
+double tune_measure(jacobi_contexto *ctx, const jacobi_kernel *kernel, int T)
+{
+    double residuo[2];
+    double error;
+    double melhor = 1e30;
+
+    for (int a = -1; a < AMOSTRAS_TUNING; a++) // a = -1: aquecimento
+    {
+        jacobi_set_initial_guess(ctx, ctx->vet_b);
+        double t0 = omp_get_wtime();
+        for (int k = 0; k < ITERACOES_TUNING; k++)
+        {
+            calculate_new_x(ctx->matrix, ctx->vet_b, ctx->vet_diag, ctx->vet_x, ctx->vet_new_x, residuo, kernel, ctx->N, ctx->ld, T);
+            calculate_error(ctx->vet_x, ctx->vet_new_x, &error, ctx->N, T);
+        }
+        double t = (omp_get_wtime() - t0) / ITERACOES_TUNING;
+        if (a >= 0 && t < melhor)
+        {
+            melhor = t;
+        }
+    }
+
+    return melhor;
+}
+
+static void print_candidate(FILE *log, const jacobi_kernel *kernel, int T, double tempo)
+{
+    if (log != NULL)
+    {
+        fprintf(log, "  threads %3d  %-6s  linhas %d  colunas %5d  agendamento %d chunk %3d: %.6e s/iteracao\n", T,
+                kernel->variante == KERNEL_LINHAS ? "linhas" : "blocos", kernel->bloco_linhas, kernel->bloco_colunas,
+                (int)kernel->agendamento, kernel->chunk, tempo);
+    }
+}
+
+// Busca por coordenadas sobre um sistema ja gerado em ctx: primeiro o numero de threads (potencias de 2 e
+// max_threads), depois a variante do kernel (blocos de linhas x faixas de colunas) e por fim o agendamento
+// do laco de linhas. Ao final o chute de ctx volta a ser o vetor B
+void tune_search(jacobi_contexto *ctx, int max_threads, jacobi_kernel *melhor, int *melhor_T, FILE *log)
+{
+    jacobi_kernel candidato;
+    double melhor_tempo;
+
+    jacobi_default_kernel(melhor);
+    *melhor_T = 1;
+    melhor_tempo = tune_measure(ctx, melhor, 1);
+    print_candidate(log, melhor, 1, melhor_tempo);
+
+    // Numero de threads: 2, 4, 8, ... e max_threads
+    for (int T = 2; T <= max_threads; T = T * 2 < max_threads || T == max_threads ? T * 2 : max_threads)
+    {
+        double tempo = tune_measure(ctx, melhor, T);
+        print_candidate(log, melhor, T, tempo);
+        if (tempo < melhor_tempo)
+        {
+            melhor_tempo = tempo;
+            *melhor_T = T;
+        }
+    }
+
+    // Variante do kernel
+    int linhas[] = {2, 4, 8};
+    int faixas[] = {0, 256, 1024, 4096};
+    for (int l = 0; l < 3; l++)
+    {
+        for (int f = 0; f < 4; f++)
+        {
+            if (faixas[f] >= ctx->N)
+            {
+                continue;
+            }
+            candidato = *melhor;
+            candidato.variante = KERNEL_BLOCOS;
+            candidato.bloco_linhas = linhas[l];
+            candidato.bloco_colunas = faixas[f];
+            double tempo = tune_measure(ctx, &candidato, *melhor_T);
+            print_candidate(log, &candidato, *melhor_T, tempo);
+            if (tempo < melhor_tempo)
+            {
+                melhor_tempo = tempo;
+                *melhor = candidato;
+            }
+        }
+    }
+
+    // Agendamento do laco de linhas (o chunk conta linhas ou blocos de linhas)
+    omp_sched_t agendamentos[] = {omp_sched_static, omp_sched_static, omp_sched_dynamic, omp_sched_dynamic, omp_sched_guided};
+    int chunks[] = {16, 64, 16, 64, 0};
+    for (int a = 0; a < 5; a++)
+    {
+        candidato = *melhor;
+        candidato.agendamento = agendamentos[a];
+        candidato.chunk = chunks[a];
+        double tempo = tune_measure(ctx, &candidato, *melhor_T);
+        print_candidate(log, &candidato, *melhor_T, tempo);
+        if (tempo < melhor_tempo)
+        {
+            melhor_tempo = tempo;
+            *melhor = candidato;
+        }
+    }
+
+    jacobi_set_initial_guess(ctx, ctx->vet_b);
+}
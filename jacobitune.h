@@ -0,0 +1,23 @@
+// Autotuning da varredura: busca o numero de threads, o agendamento OpenMP e a variante do kernel
+// (blocos de linhas e faixas de colunas) mais rapidos para uma ordem N nesta maquina e guarda o resultado
+// em um arquivo local, indexado pelo modelo do processador e pela faixa de N
+
+#ifndef JACOBITUNE_H
+#define JACOBITUNE_H
+
+#include <stdio.h>
+
+#include "jacobipar.h"
+
+#define ARQUIVO_TUNING "jacobi_tuning.txt" // padrao; a variavel de ambiente JACOBI_TUNING o substitui
+#define ITERACOES_TUNING 10                // iteracoes cronometradas por amostra
+#define AMOSTRAS_TUNING 3                  // amostras por candidato (vale a menor)
+
+void cpu_model(char *modelo, int tamanho);
+const char *tune_file(void);
+int tune_lookup(const char *nome_arq, int N, jacobi_kernel *kernel, int *T);
+int tune_save(const char *nome_arq, int N, const jacobi_kernel *kernel, int T);
+double tune_measure(jacobi_contexto *ctx, const jacobi_kernel *kernel, int T);
+void tune_search(jacobi_contexto *ctx, int max_threads, jacobi_kernel *melhor, int *melhor_T, FILE *log);
+
+#endif
@@ -1,121 +1,947 @@
+// to compile: make teste || make all
+// to execute: ./teste [ordem_matriz] [amostras] || ./teste escalabilidade [amostras] || ./teste regressao [--gravar]
+// Benchmark em processo: liga o solver (jacobipar.c compilado com -DJACOBI_SEM_MAIN) e mede cada fase
+// (geracao, normalizacao, iteracoes, verificacao) com omp_get_wtime, sem criacao de processos
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 #include <omp.h>
-#include <time.h>
+#include <unistd.h>
+
+#include "jacobipar.h"
+#include "jacobitune.h"
+#include "jacobiafin.h"
 
 #define TIME_OF_EXECUTION 30
 #define ORDEM_MATRIZ 1500
-#define LINE_FOR_VERIFICATION 0
+#define AQUECIMENTO 3 // execucoes descartadas antes das medicoes (caches, paginas, frequencia)
+#define SEMENTE 42    // semente fixa: todas as amostras resolvem o mesmo sistema
+
+#define AMOSTRAS_ESCALABILIDADE 5   // amostras por configuracao no teste de escalabilidade
+#define ITERACOES_ESCALABILIDADE 20 // iteracoes (varreduras) cronometradas por amostra
+#define NUM_TAMANHOS 3              // tamanhos da matriz: cabe na L2, cabe na L3, DRAM
+
+#define VERSAO_BASELINE 1            // versao do formato dos arquivos de baseline
+#define DIRETORIO_BASELINES "baselines"
+#define AMOSTRAS_REGRESSAO 10        // amostras por configuracao no teste de regressao
+#define ITERACOES_REGRESSAO 200      // iteracoes cronometradas por amostra
+#define LIMIAR_REGRESSAO 0.05        // aumento relativo da mediana considerado regressao
+#define SIGNIFICANCIA_REGRESSAO 0.01 // p-valor maximo do teste de Mann-Whitney
+#define PROFUNDIDADE_ANDERSON 5
+#define MAX_CONFIGURACOES 64
 
-void txtToCSV(char *nome_txt, char *nome_csv);
+#define NUM_FASES 5
+#define FASE_GERAR 0
+#define FASE_NORMALIZAR 1
+#define FASE_ITERAR 2
+#define FASE_VERIFICAR 3
+#define FASE_TOTAL 4
 
-int main()
+const char *nome_fases[NUM_FASES] = {"Gerar", "Normalizar", "Iterar", "Verificar", "Total"};
+
+// Estatisticas de um conjunto de amostras de tempo
+typedef struct
 {
-    char *comando = (char*) malloc(100 * sizeof(char));
-    char *nome_txt = (char*) malloc(50 * sizeof(char));
-    char *nome_csv = (char*) malloc(50 * sizeof(char));
-    int retorno = 0;
+    double media;
+    double desvio;
+    double mediana;
+    double p05;
+    double p95;
+    double ic_inf; // intervalo de confianca de 95% da media
+    double ic_sup;
+} estatisticas;
+
+void run_once(int N, int T, double *tempos, int *iteracoes);
+void run_benchmark(int N, int T, int amostras, FILE *arq_resumo);
+void compute_statistics(double *amostras, int n, estatisticas *est);
+void run_scaling(int amostras);
+int run_regression(int gravar);
 
-    sprintf(nome_txt, "testeSeq_%d.txt", ORDEM_MATRIZ);
-    sprintf(nome_csv, "testeSeq_%d.csv", ORDEM_MATRIZ);
-    // Teste Sequencial
-    for (int i = 0; i < TIME_OF_EXECUTION; i++)
+int main(int argc, char **argv)
+{
+    if (argc > 1 && strcmp(argv[1], "escalabilidade") == 0)
     {
-        sprintf(comando, "time -p -o %s -a ./jacobiseq.out %d %d %d", nome_txt, ORDEM_MATRIZ, (int)clock(), LINE_FOR_VERIFICATION);
-        retorno = system(comando);
+        // Um lugar OpenMP por nucleo fisico com threads consecutivas em nucleos consecutivos: ate o numero de
+        // nucleos, cada thread fica sozinha em um nucleo (SMT de fato desligado)
+        affinity_reexec_places("cores", "close", "cores", argv);
+        run_scaling(argc > 2 ? atoi(argv[2]) : AMOSTRAS_ESCALABILIDADE);
+        return 0;
+    }
 
-        if (retorno == -1)
-        {
-            printf("Ocorreu um erro ao tentar executar o comando.\n");
-        }
+    if (argc > 1 && strcmp(argv[1], "regressao") == 0)
+    {
+        return run_regression(argc > 2 && strcmp(argv[2], "--gravar") == 0);
     }
-    // transforma em csv
-    txtToCSV(nome_txt, nome_csv);
 
-    // Teste Paralelo
-    int max_threads = omp_get_max_threads(); // roda com o número máximmo de theads lógicas disponíveis
-    for (int j = 2; j <= max_threads; j+=2) {
-        sprintf(nome_txt, "testePar_%d_threads%d.txt", ORDEM_MATRIZ, j);
-        sprintf(nome_csv, "testePar_%d_threads%d.csv", ORDEM_MATRIZ, j);
-        for (int i = 0; i < TIME_OF_EXECUTION; i++) {
-            sprintf(comando, "time -p -o %s -a ./jacobipar.out %d %d %d %d", nome_txt, ORDEM_MATRIZ, (int)clock(), j, LINE_FOR_VERIFICATION);
+    int N = argc > 1 ? atoi(argv[1]) : ORDEM_MATRIZ;
+    int amostras = argc > 2 ? atoi(argv[2]) : TIME_OF_EXECUTION;
+    if (N <= 0 || amostras <= 0)
+    {
+        printf("Wrong arguments. Please use teste [ordem_matriz] [amostras] or teste escalabilidade [amostras] or teste regressao [--gravar]\n");
+        exit(0);
+    }
 
-            retorno = system(comando);
+    char nome_csv[64];
+    sprintf(nome_csv, "resumo_%d.csv", N);
+    FILE *arq_resumo = fopen(nome_csv, "w");
+    if (arq_resumo == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_csv);
+        return 1;
+    }
+    fprintf(arq_resumo, "Threads,Fase,Media,Desvio,Mediana,P05,P95,IC95_inf,IC95_sup\n");
 
-            if (retorno == -1)
-            {
-                printf("Ocorreu um erro ao tentar executar o comando.\n");
-            }
-        }
-        // transforma em csv
-        txtToCSV(nome_txt, nome_csv);
+    // Teste Sequencial (solver com uma thread)
+    run_benchmark(N, 1, amostras, arq_resumo);
+
+    // Teste Paralelo
+    int max_threads = omp_get_max_threads(); // roda com o número máximmo de theads lógicas disponíveis
+    for (int j = 2; j <= max_threads; j += 2)
+    {
+        run_benchmark(N, j, amostras, arq_resumo);
     }
+
+    fclose(arq_resumo);
     return 0;
 }
 
-void txtToCSV(char *nome_txt, char *nome_csv)
+// Executa uma resolucao completa medindo cada fase (em segundos)
+void run_once(int N, int T, double *tempos, int *iteracoes)
+{
+    jacobi_contexto ctx;
+    jacobi_opcoes opcoes;
+    jacobi_default_options(&opcoes);
+    jacobi_verificacao verificacao;
+
+    jacobi_init(&ctx, N, T);
+
+    double t0 = omp_get_wtime();
+    srand(SEMENTE);
+    init_matrix(ctx.matrix, ctx.vet_b, N, ctx.ld);
+    double t1 = omp_get_wtime();
+    normalize_matrix(ctx.matrix, ctx.vet_b, ctx.vet_diag, N, ctx.ld, T);
+    jacobi_set_initial_guess(&ctx, ctx.vet_b);
+    double t2 = omp_get_wtime();
+    jacobi_solve(&ctx, &opcoes);
+    double t3 = omp_get_wtime();
+    jacobi_verify(&ctx, NULL, &verificacao);
+    double t4 = omp_get_wtime();
+
+    tempos[FASE_GERAR] = t1 - t0;
+    tempos[FASE_NORMALIZAR] = t2 - t1;
+    tempos[FASE_ITERAR] = t3 - t2;
+    tempos[FASE_VERIFICAR] = t4 - t3;
+    tempos[FASE_TOTAL] = t4 - t0;
+    *iteracoes = ctx.cont;
+
+    jacobi_free(&ctx);
+}
+
+// Mede uma configuracao (N, T): descarta AQUECIMENTO execucoes, grava as amostras em CSV e o resumo
+// estatistico de cada fase em arq_resumo
+void run_benchmark(int N, int T, int amostras, FILE *arq_resumo)
 {
-    FILE *arq_txt = fopen(nome_txt, "r");
-    if (arq_txt == NULL)
+    double tempos[NUM_FASES];
+    int iteracoes = 0;
+    double *medidas = (double *)malloc(sizeof(double) * NUM_FASES * amostras); // medidas[fase * amostras + i]
+    if (medidas == NULL)
     {
-        printf("Erro ao abrir o arquivo %s\n", nome_txt);
-        return;
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+
+    for (int i = 0; i < AQUECIMENTO; i++)
+    {
+        run_once(N, T, tempos, &iteracoes);
     }
 
+    char nome_csv[64];
+    if (T == 1)
+    {
+        sprintf(nome_csv, "testeSeq_%d.csv", N);
+    }
+    else
+    {
+        sprintf(nome_csv, "testePar_%d_threads%d.csv", N, T);
+    }
     FILE *arq_csv = fopen(nome_csv, "w");
     if (arq_csv == NULL)
     {
         printf("Erro ao abrir o arquivo %s\n", nome_csv);
+        free(medidas);
         return;
     }
-    fprintf(arq_csv, "Real,User,Sys\n");
+    fprintf(arq_csv, "Gerar,Normalizar,Iterar,Verificar,Total,Iteracoes\n");
 
-    char *linha = (char *)malloc(100 * sizeof(char));
-    float *real = (float *)malloc(TIME_OF_EXECUTION * sizeof(float));
-    float *user = (float *)malloc(TIME_OF_EXECUTION * sizeof(float));
-    float *sys = (float *)malloc(TIME_OF_EXECUTION * sizeof(float));
+    for (int i = 0; i < amostras; i++)
+    {
+        run_once(N, T, tempos, &iteracoes);
+        for (int f = 0; f < NUM_FASES; f++)
+        {
+            medidas[f * amostras + i] = tempos[f];
+        }
+        fprintf(arq_csv, "%f,%f,%f,%f,%f,%d\n", tempos[FASE_GERAR], tempos[FASE_NORMALIZAR], tempos[FASE_ITERAR],
+                tempos[FASE_VERIFICAR], tempos[FASE_TOTAL], iteracoes);
+    }
+    fclose(arq_csv);
+
+    printf("N = %d, %d thread(s), %d iteracoes, %d amostras\n", N, T, iteracoes, amostras);
+    printf("%-11s %10s %10s %10s %10s %23s\n", "Fase", "Mediana", "P05", "P95", "Media", "IC 95%");
+    for (int f = 0; f < NUM_FASES; f++)
+    {
+        estatisticas est;
+        compute_statistics(medidas + f * amostras, amostras, &est);
+        printf("%-11s %10.6f %10.6f %10.6f %10.6f [%10.6f, %10.6f]\n", nome_fases[f], est.mediana, est.p05, est.p95,
+               est.media, est.ic_inf, est.ic_sup);
+        fprintf(arq_resumo, "%d,%s,%f,%f,%f,%f,%f,%f,%f\n", T, nome_fases[f], est.media, est.desvio, est.mediana,
+                est.p05, est.p95, est.ic_inf, est.ic_sup);
+    }
+    printf("\n");
+
+    free(medidas);
+}
 
-    int i = 0;
-    int j = 0;
-    while (fgets(linha, 100, arq_txt) != NULL)
+int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Percentil p (0 a 1) de um vetor ordenado, com interpolacao linear entre as amostras vizinhas
+double percentile(double *ordenado, int n, double p)
+{
+    double pos = p * (n - 1);
+    int i = (int)pos;
+    if (i >= n - 1)
+    {
+        return ordenado[n - 1];
+    }
+    return ordenado[i] + (pos - i) * (ordenado[i + 1] - ordenado[i]);
+}
+
+// Quantil 97,5% da distribuicao t de Student com gl graus de liberdade
+double t_quantile(int gl)
+{
+    static const double tabela[30] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                      2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                      2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (gl < 1)
     {
-        if (linha[0] == 'r')
+        return 0;
+    }
+    if (gl <= 30)
+    {
+        return tabela[gl - 1];
+    }
+    return 1.96;
+}
+
+void compute_statistics(double *amostras, int n, estatisticas *est)
+{
+    double *ordenado = (double *)malloc(sizeof(double) * n);
+    if (ordenado == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+    memcpy(ordenado, amostras, sizeof(double) * n);
+    qsort(ordenado, n, sizeof(double), compare_doubles);
+
+    double soma = 0;
+    for (int i = 0; i < n; i++)
+    {
+        soma += amostras[i];
+    }
+    est->media = soma / n;
+
+    double soma_quad = 0;
+    for (int i = 0; i < n; i++)
+    {
+        soma_quad += (amostras[i] - est->media) * (amostras[i] - est->media);
+    }
+    est->desvio = n > 1 ? sqrt(soma_quad / (n - 1)) : 0;
+
+    est->mediana = percentile(ordenado, n, 0.5);
+    est->p05 = percentile(ordenado, n, 0.05);
+    est->p95 = percentile(ordenado, n, 0.95);
+
+    double margem = t_quantile(n - 1) * est->desvio / sqrt(n);
+    est->ic_inf = est->media - margem;
+    est->ic_sup = est->media + margem;
+
+    free(ordenado);
+}
+
+// Tamanho (bytes) da cache de dados/unificada de nivel 'nivel' da cpu0, 0 se desconhecido
+long read_cache_size(int nivel)
+{
+    for (int indice = 0;; indice++)
+    {
+        char caminho[128];
+        char tipo[32];
+        char tamanho[32];
+        int nivel_lido = 0;
+
+        sprintf(caminho, "/sys/devices/system/cpu/cpu0/cache/index%d/level", indice);
+        FILE *arq = fopen(caminho, "r");
+        if (arq == NULL)
         {
-            sscanf(linha, "real %f", &real[i]);
-            j++;
+            return 0;
         }
-        else if (linha[0] == 'u')
+        int lidos = fscanf(arq, "%d", &nivel_lido);
+        fclose(arq);
+
+        sprintf(caminho, "/sys/devices/system/cpu/cpu0/cache/index%d/type", indice);
+        arq = fopen(caminho, "r");
+        if (arq == NULL)
         {
-            sscanf(linha, "user %f", &user[i]);
-            j++;
+            return 0;
         }
-        else if (linha[0] == 's')
+        lidos += fscanf(arq, "%31s", tipo);
+        fclose(arq);
+
+        if (lidos != 2 || nivel_lido != nivel || strcmp(tipo, "Instruction") == 0)
         {
-            sscanf(linha, "sys %f", &sys[i]);
-            j++;
+            continue;
         }
 
-        if (j == 3)
+        sprintf(caminho, "/sys/devices/system/cpu/cpu0/cache/index%d/size", indice);
+        arq = fopen(caminho, "r");
+        if (arq == NULL)
+        {
+            return 0;
+        }
+        long valor = 0;
+        char unidade = 0;
+        lidos = fscanf(arq, "%31s", tamanho);
+        fclose(arq);
+        if (lidos != 1 || sscanf(tamanho, "%ld%c", &valor, &unidade) < 1)
+        {
+            return 0;
+        }
+        if (unidade == 'K')
+        {
+            valor *= 1024;
+        }
+        else if (unidade == 'M')
         {
-            fprintf(arq_csv, "%f,%f,%f\n", real[i], user[i], sys[i]);
-            i++;
-            j = 0;
+            valor *= 1024 * 1024;
         }
+        return valor;
     }
+}
 
-    fclose(arq_txt);
-    fclose(arq_csv);
-    free(linha);
-    free(real);
-    free(user);
-    free(sys);
+// Ordem da matriz cujo armazenamento (8 N^2 bytes) ocupa 'bytes'
+int order_for_bytes(double bytes)
+{
+    int N = (int)sqrt(bytes / sizeof(double));
+    return N > 16 ? N : 16;
+}
+
+// Mediana do tempo de uma iteracao (varredura + erro) de um sistema ja gerado, com ctx->T threads
+double time_per_iteration(jacobi_contexto *ctx, int amostras)
+{
+    double residuo[2];
+    double *tempos = (double *)malloc(sizeof(double) * amostras);
+    if (tempos == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+
+    for (int a = -1; a < amostras; a++) // a = -1: aquecimento
+    {
+        jacobi_set_initial_guess(ctx, ctx->vet_b);
+        double t0 = omp_get_wtime();
+        for (int k = 0; k < ITERACOES_ESCALABILIDADE; k++)
+        {
+            calculate_new_x(ctx->matrix, ctx->vet_b, ctx->vet_diag, ctx->vet_x, ctx->vet_new_x, residuo, &ctx->kernel, ctx->N, ctx->ld, ctx->T);
+            calculate_error(ctx->vet_x, ctx->vet_new_x, &ctx->error, ctx->N, ctx->T);
+        }
+        if (a >= 0)
+        {
+            tempos[a] = (omp_get_wtime() - t0) / ITERACOES_ESCALABILIDADE;
+        }
+    }
+
+    estatisticas est;
+    compute_statistics(tempos, amostras, &est);
+    free(tempos);
+    return est.mediana;
+}
+
+// Gera o sistema de ordem N e mede o tempo por iteracao com T threads
+double measure_configuration(int N, int T, int amostras)
+{
+    jacobi_contexto ctx;
+    jacobi_init(&ctx, N, T);
+    jacobi_generate(&ctx, SEMENTE);
+    double tempo = time_per_iteration(&ctx, amostras);
+    jacobi_free(&ctx);
+    return tempo;
+}
+
+// Teste de escalabilidade: varre o numero de threads (1 ate o numero de nucleos fisicos, e todas as
+// cpus logicas quando ha SMT) para matrizes que cabem na L2, na L3 e que vao para a DRAM. Gera tabelas
+// de escalabilidade forte (N fixo) e fraca (trabalho N^2 / T constante) com speedup, eficiencia e a
+// fracao serial de Karp-Flatt, em escalabilidade.csv e escalabilidade.json
+void run_scaling(int amostras)
+{
+    static jacobi_topologia topo;
+    read_topology(&topo); // cpus da mascara original do processo
+    int logicos = topo.num_cpus;
+    int fisicos = topo.num_nucleos;
+    int vinculadas = omp_get_num_places() > 0;
+    long l2 = read_cache_size(2);
+    long l3 = read_cache_size(3);
+    double memoria = (double)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGESIZE);
+
+    if (amostras <= 0)
+    {
+        amostras = AMOSTRAS_ESCALABILIDADE;
+    }
+    if (l2 <= 0)
+    {
+        l2 = 1024 * 1024;
+    }
+    if (l3 <= 0)
+    {
+        l3 = 8 * l2;
+    }
+
+    // Lista de threads: 1..fisicos (uma por nucleo, SMT desligado) e todas as logicas (SMT ligado)
+    int threads[MAX_CPUS_AFINIDADE + 1];
+    int smt[MAX_CPUS_AFINIDADE + 1];
+    int num_threads = 0;
+    for (int t = 1; t <= fisicos && t <= MAX_CPUS_AFINIDADE; t++)
+    {
+        threads[num_threads] = t;
+        smt[num_threads++] = 0;
+    }
+    if (logicos > fisicos)
+    {
+        threads[num_threads] = logicos;
+        smt[num_threads++] = 1;
+    }
+
+    // Tamanhos: metade da L2, metade da L3 e 4x a L3 (limitado a 1/4 da memoria fisica)
+    const char *nome_tamanho[NUM_TAMANHOS] = {"L2", "L3", "DRAM"};
+    double bytes_tamanho[NUM_TAMANHOS] = {l2 / 2.0, l3 / 2.0, fmin(4.0 * l3, memoria / 4)};
+
+    FILE *csv = fopen("escalabilidade.csv", "w");
+    FILE *json = fopen("escalabilidade.json", "w");
+    if (csv == NULL || json == NULL)
+    {
+        printf("Erro ao abrir os arquivos de saida do teste de escalabilidade\n");
+        exit(1);
+    }
+
+    fprintf(csv, "Tipo,Tamanho,N,Threads,SMT,Tempo_iteracao,Speedup,Eficiencia,Karp_Flatt\n");
+    fprintf(json, "{\n  \"cpus_logicas\": %d,\n  \"nucleos_fisicos\": %d,\n  \"cache_l2\": %ld,\n  \"cache_l3\": %ld,\n",
+            logicos, fisicos, l2, l3);
+    fprintf(json, "  \"threads_vinculadas\": %s,\n", vinculadas ? "true" : "false");
+    fprintf(json, "  \"iteracoes_por_amostra\": %d,\n  \"amostras\": %d,\n  \"resultados\": [", ITERACOES_ESCALABILIDADE, amostras);
+    int primeiro = 1;
+
+    printf("%d cpus logicas, %d nucleos fisicos, L2 = %ld KiB, L3 = %ld KiB\n", logicos, fisicos, l2 / 1024, l3 / 1024);
+    if (vinculadas)
+    {
+        printf("Threads vinculadas: OMP_PLACES=%s, OMP_PROC_BIND=%s\n\n", getenv("OMP_PLACES"),
+               getenv("OMP_PROC_BIND") != NULL ? getenv("OMP_PROC_BIND") : "padrao");
+    }
+    else
+    {
+        printf("Threads sem vinculo (OMP_PLACES indisponivel): as linhas sem SMT nao sao garantidas\n\n");
+    }
+    printf("%-6s %-5s %6s %7s %4s %14s %9s %10s %10s\n", "Tipo", "Tam.", "N", "Threads", "SMT", "Tempo/iter (s)",
+           "Speedup", "Eficiencia", "Karp-Flatt");
+
+    for (int tipo = 0; tipo < 2; tipo++) // 0: escalabilidade forte, 1: fraca
+    {
+        for (int tam = 0; tam < NUM_TAMANHOS; tam++)
+        {
+            int N_base = order_for_bytes(bytes_tamanho[tam]);
+            double tempo_base = 0;
+
+            for (int k = 0; k < num_threads; k++)
+            {
+                int T = threads[k];
+                // Escalabilidade fraca: trabalho por iteracao (N^2) proporcional ao numero de threads
+                int N = tipo == 0 ? N_base : (int)(N_base * sqrt(T));
+                if (tipo == 1 && (double)N * N * sizeof(double) > memoria / 2)
+                {
+                    break;
+                }
+
+                double tempo = measure_configuration(N, T, amostras);
+                if (k == 0)
+                {
+                    tempo_base = tempo;
+                }
+
+                // Forte: S = t1 / tp. Fraca: S = p * t1 / tp (speedup escalado)
+                double speedup = tipo == 0 ? tempo_base / tempo : T * tempo_base / tempo;
+                double eficiencia = speedup / T;
+                double karp_flatt = T > 1 ? (1 / speedup - 1.0 / T) / (1 - 1.0 / T) : 0;
+
+                printf("%-6s %-5s %6d %7d %4d %14.6e %9.3f %10.3f %10.4f\n", tipo == 0 ? "forte" : "fraca",
+                       nome_tamanho[tam], N, T, smt[k], tempo, speedup, eficiencia, karp_flatt);
+                fprintf(csv, "%s,%s,%d,%d,%d,%e,%f,%f,%f\n", tipo == 0 ? "forte" : "fraca", nome_tamanho[tam], N, T,
+                        smt[k], tempo, speedup, eficiencia, karp_flatt);
+                fprintf(json, "%s\n    {\"tipo\": \"%s\", \"tamanho\": \"%s\", \"N\": %d, \"threads\": %d, \"smt\": %s, "
+                              "\"tempo_iteracao\": %e, \"speedup\": %f, \"eficiencia\": %f, \"karp_flatt\": %f}",
+                        primeiro ? "" : ",", tipo == 0 ? "forte" : "fraca", nome_tamanho[tam], N, T,
+                        smt[k] ? "true" : "false", tempo, speedup, eficiencia, karp_flatt);
+                primeiro = 0;
+            }
+        }
+    }
+
+    fprintf(json, "\n  ]\n}\n");
+    fclose(csv);
+    fclose(json);
+}
+
+// Configuracao do teste de regressao e suas amostras (segundos por iteracao)
+typedef struct
+{
+    int N;
+    int T;
+    char metodo[16]; // "jacobi" ou "anderson"
+    int num_amostras;
+    double amostras[AMOSTRAS_REGRESSAO];
+} configuracao_regressao;
+
+// Amostras de tempo por iteracao de uma configuracao: o sistema eh gerado uma vez e cada amostra
+// reinicia o chute e executa ITERACOES_REGRESSAO iteracoes (tolerancia 0: o criterio nunca para antes)
+void measure_regression(configuracao_regressao *config)
+{
+    jacobi_contexto ctx;
+    jacobi_opcoes opcoes;
+    jacobi_default_options(&opcoes);
+    opcoes.tol = 0;
+    opcoes.max_iteracoes = ITERACOES_REGRESSAO;
+    opcoes.anderson = strcmp(config->metodo, "anderson") == 0 ? PROFUNDIDADE_ANDERSON : 0;
+
+    jacobi_init(&ctx, config->N, config->T);
+    jacobi_generate(&ctx, SEMENTE);
+
+    config->num_amostras = AMOSTRAS_REGRESSAO;
+    for (int a = -1; a < AMOSTRAS_REGRESSAO; a++) // a = -1: aquecimento
+    {
+        jacobi_set_initial_guess(&ctx, ctx.vet_b);
+        jacobi_solve(&ctx, &opcoes);
+        if (a >= 0)
+        {
+            config->amostras[a] = ctx.tempo_iteracoes / ctx.cont;
+        }
+    }
+
+    jacobi_free(&ctx);
+}
+
+// Grava as configuracoes medidas como baseline (uma configuracao por linha)
+int write_baseline(const char *nome_arq, const char *modelo, configuracao_regressao *configs, int num_configs)
+{
+    FILE *arq = fopen(nome_arq, "w");
+    if (arq == NULL)
+    {
+        printf("Erro ao abrir o arquivo %s\n", nome_arq);
+        return 0;
+    }
+
+    fprintf(arq, "{\n  \"versao\": %d,\n  \"cpu\": \"%s\",\n  \"iteracoes_por_amostra\": %d,\n  \"configuracoes\": [\n",
+            VERSAO_BASELINE, modelo, ITERACOES_REGRESSAO);
+    for (int c = 0; c < num_configs; c++)
+    {
+        fprintf(arq, "    {\"N\": %d, \"threads\": %d, \"metodo\": \"%s\", \"amostras\": [", configs[c].N, configs[c].T,
+                configs[c].metodo);
+        for (int a = 0; a < configs[c].num_amostras; a++)
+        {
+            fprintf(arq, "%s%.9e", a > 0 ? ", " : "", configs[c].amostras[a]);
+        }
+        fprintf(arq, "]}%s\n", c < num_configs - 1 ? "," : "");
+    }
+    fprintf(arq, "  ]\n}\n");
+
+    fclose(arq);
+    return 1;
+}
+
+// Leitor JSON minimo para as baselines: os campos sao procurados pela chave, em qualquer ordem e com
+// qualquer formatacao. Cada funcao avanca *p e retorna 0 em erro de sintaxe
+static void skip_spaces(const char **p)
+{
+    while (**p == ' ' || **p == '\t' || **p == '\n' || **p == '\r')
+    {
+        (*p)++;
+    }
+}
+
+static int expect_char(const char **p, char c)
+{
+    skip_spaces(p);
+    if (**p != c)
+    {
+        return 0;
+    }
+    (*p)++;
+    return 1;
+}
+
+// Le uma string (sem escapes, que as baselines nao usam) em destino, truncada em tamanho - 1
+static int parse_string(const char **p, char *destino, int tamanho)
+{
+    if (!expect_char(p, '"'))
+    {
+        return 0;
+    }
+    int k = 0;
+    while (**p != '"' && **p != '\0')
+    {
+        if (k < tamanho - 1)
+        {
+            destino[k++] = **p;
+        }
+        (*p)++;
+    }
+    destino[k] = '\0';
+    return expect_char(p, '"');
+}
 
-    char comando[100];
-    sprintf(comando, "rm %s", nome_txt);
-    if (system(comando) == -1)
+static int parse_number(const char **p, double *valor)
+{
+    char *fim;
+    skip_spaces(p);
+    *valor = strtod(*p, &fim);
+    if (fim == *p)
     {
-        printf("Erro ao tentar remover %s.\n", nome_txt);
+        return 0;
     }
+    *p = fim;
+    return 1;
+}
+
+// Pula um valor de uma chave desconhecida (string, numero, literal, vetor ou objeto) ate a virgula ou o
+// fechamento do objeto que o contem
+static int skip_value(const char **p)
+{
+    int profundidade = 0;
+    while (1)
+    {
+        char c = **p;
+        if (c == '\0')
+        {
+            return 0;
+        }
+        if (c == '"')
+        {
+            char ignorada[1];
+            if (!parse_string(p, ignorada, 1))
+            {
+                return 0;
+            }
+            continue;
+        }
+        if (profundidade == 0 && (c == ',' || c == '}' || c == ']'))
+        {
+            return 1;
+        }
+        profundidade += (c == '[' || c == '{') - (c == ']' || c == '}');
+        (*p)++;
+    }
+}
+
+// Percorre os pares chave: valor de um objeto, chamando campo(p, chave, dados) para cada um (que le o
+// valor ou retorna -1 para pula-lo)
+static int parse_object(const char **p, int (*campo)(const char **, const char *, void *), void *dados)
+{
+    char chave[64];
+    if (!expect_char(p, '{'))
+    {
+        return 0;
+    }
+    skip_spaces(p);
+    if (**p == '}')
+    {
+        (*p)++;
+        return 1;
+    }
+    do
+    {
+        if (!parse_string(p, chave, sizeof(chave)) || !expect_char(p, ':'))
+        {
+            return 0;
+        }
+        int lido = campo(p, chave, dados);
+        if (lido == 0 || (lido < 0 && !skip_value(p)))
+        {
+            return 0;
+        }
+    } while (expect_char(p, ','));
+    return expect_char(p, '}');
+}
+
+// Campos de uma configuracao: N, threads, metodo e amostras
+static int config_field(const char **p, const char *chave, void *dados)
+{
+    configuracao_regressao *config = (configuracao_regressao *)dados;
+    double valor;
+
+    if (strcmp(chave, "N") == 0 || strcmp(chave, "threads") == 0)
+    {
+        if (!parse_number(p, &valor))
+        {
+            return 0;
+        }
+        *(strcmp(chave, "N") == 0 ? &config->N : &config->T) = (int)valor;
+        return 1;
+    }
+    if (strcmp(chave, "metodo") == 0)
+    {
+        return parse_string(p, config->metodo, sizeof(config->metodo));
+    }
+    if (strcmp(chave, "amostras") == 0)
+    {
+        config->num_amostras = 0;
+        if (!expect_char(p, '['))
+        {
+            return 0;
+        }
+        skip_spaces(p);
+        if (**p == ']')
+        {
+            (*p)++;
+            return 1;
+        }
+        do
+        {
+            if (!parse_number(p, &valor))
+            {
+                return 0;
+            }
+            if (config->num_amostras < AMOSTRAS_REGRESSAO)
+            {
+                config->amostras[config->num_amostras++] = valor;
+            }
+        } while (expect_char(p, ','));
+        return expect_char(p, ']');
+    }
+    return -1;
+}
 
-    return;
-}
\ No newline at end of file
+// Baseline em leitura: versao e configuracoes
+typedef struct
+{
+    int versao;
+    int num_configs;
+    configuracao_regressao *configs;
+} baseline_lida;
+
+static int baseline_field(const char **p, const char *chave, void *dados)
+{
+    baseline_lida *base = (baseline_lida *)dados;
+    double valor;
+
+    if (strcmp(chave, "versao") == 0)
+    {
+        if (!parse_number(p, &valor))
+        {
+            return 0;
+        }
+        base->versao = (int)valor;
+        return 1;
+    }
+    if (strcmp(chave, "configuracoes") == 0)
+    {
+        if (!expect_char(p, '['))
+        {
+            return 0;
+        }
+        skip_spaces(p);
+        if (**p == ']')
+        {
+            (*p)++;
+            return 1;
+        }
+        do
+        {
+            configuracao_regressao ignorada;
+            configuracao_regressao *config = base->num_configs < MAX_CONFIGURACOES ? &base->configs[base->num_configs] : &ignorada;
+            memset(config, 0, sizeof(*config));
+            config->N = -1;
+            if (!parse_object(p, config_field, config))
+            {
+                return 0;
+            }
+            if (config != &ignorada && config->N > 0 && config->T > 0 && config->metodo[0] != '\0')
+            {
+                base->num_configs++;
+            }
+        } while (expect_char(p, ','));
+        return expect_char(p, ']');
+    }
+    return -1;
+}
+
+// Le uma baseline gravada por write_baseline. Retorna o numero de configuracoes, -1 se o arquivo nao
+// existe ou tem outra versao do formato, -2 se o JSON eh invalido
+int read_baseline(const char *nome_arq, configuracao_regressao *configs)
+{
+    FILE *arq = fopen(nome_arq, "r");
+    if (arq == NULL)
+    {
+        return -1;
+    }
+    fseek(arq, 0, SEEK_END);
+    long tamanho = ftell(arq);
+    rewind(arq);
+    char *texto = (char *)malloc(tamanho + 1);
+    if (texto == NULL)
+    {
+        printf("Erro de alocação de memória\n");
+        exit(1);
+    }
+    size_t lidos = fread(texto, 1, tamanho, arq);
+    texto[lidos] = '\0';
+    fclose(arq);
+
+    baseline_lida base = {-1, 0, configs};
+    const char *p = texto;
+    int ok = parse_object(&p, baseline_field, &base);
+    free(texto);
+
+    if (!ok)
+    {
+        return -2;
+    }
+    return base.versao == VERSAO_BASELINE ? base.num_configs : -1;
+}
+
+// Teste U de Mann-Whitney unilateral (aproximacao normal com correcao de empates): p-valor da hipotese
+// de que as amostras 'novas' sao estocasticamente maiores (mais lentas) que as da 'base'
+double mann_whitney_greater(double *base, int nb, double *novas, int nn)
+{
+    double u = 0;
+    for (int i = 0; i < nn; i++)
+    {
+        for (int j = 0; j < nb; j++)
+        {
+            u += novas[i] > base[j] ? 1 : (novas[i] == base[j] ? 0.5 : 0);
+        }
+    }
+
+    double media = nb * nn / 2.0;
+    double desvio = sqrt(nb * nn * (nb + nn + 1) / 12.0);
+    if (desvio == 0)
+    {
+        return 1;
+    }
+    double z = (u - media - 0.5) / desvio; // correcao de continuidade
+    return 0.5 * erfc(z / sqrt(2));
+}
+
+// Teste de regressao de desempenho: mede um conjunto fixo de configuracoes (N, threads, metodo) e
+// compara com a baseline do processador em baselines/<cpu>.json. Uma configuracao regride quando a
+// mediana piora mais que LIMIAR_REGRESSAO e o teste de Mann-Whitney eh significativo. Com gravar != 0,
+// substitui a baseline pelas medidas atuais. Retorna 1 se houve regressao
+int run_regression(int gravar)
+{
+    int ordens[] = {500, 2000};
+    const char *metodos[] = {"jacobi", "anderson"};
+    int threads[] = {1, omp_get_max_threads()};
+    int num_threads = threads[1] > 1 ? 2 : 1;
+
+    static configuracao_regressao configs[MAX_CONFIGURACOES];
+    static configuracao_regressao base[MAX_CONFIGURACOES];
+    int num_configs = 0;
+
+    char modelo[128];
+    char nome_arq[256];
+    cpu_model(modelo, sizeof(modelo));
+    snprintf(nome_arq, sizeof(nome_arq), "%s/%s.json", DIRETORIO_BASELINES, modelo);
+
+    for (int n = 0; n < 2; n++)
+    {
+        for (int t = 0; t < num_threads; t++)
+        {
+            for (int m = 0; m < 2; m++)
+            {
+                configuracao_regressao *config = &configs[num_configs++];
+                config->N = ordens[n];
+                config->T = threads[t];
+                snprintf(config->metodo, sizeof(config->metodo), "%s", metodos[m]);
+                measure_regression(config);
+            }
+        }
+    }
+
+    if (gravar)
+    {
+        if (!write_baseline(nome_arq, modelo, configs, num_configs))
+        {
+            return 1;
+        }
+        printf("Baseline gravada em %s\n", nome_arq);
+        return 0;
+    }
+
+    int num_base = read_baseline(nome_arq, base);
+    if (num_base < 0)
+    {
+        printf(num_base == -2 ? "Baseline %s invalida (JSON mal formado)\n"
+                              : "Baseline %s inexistente ou de outra versao; grave com: teste regressao --gravar\n",
+               nome_arq);
+        return 1;
+    }
+
+    int regressoes = 0;
+    int sem_base = 0;
+    printf("%6s %7s %-9s %14s %14s %9s %9s  %s\n", "N", "Threads", "Metodo", "Base (s/it)", "Atual (s/it)", "Variacao",
+           "p-valor", "Resultado");
+    for (int c = 0; c < num_configs; c++)
+    {
+        configuracao_regressao *config = &configs[c];
+        configuracao_regressao *ref = NULL;
+        for (int b = 0; b < num_base; b++)
+        {
+            if (base[b].N == config->N && base[b].T == config->T && strcmp(base[b].metodo, config->metodo) == 0)
+            {
+                ref = &base[b];
+            }
+        }
+
+        estatisticas atual;
+        compute_statistics(config->amostras, config->num_amostras, &atual);
+        if (ref == NULL || ref->num_amostras == 0)
+        {
+            // Configuracao sem referencia (ex.: outro numero de threads) nao pode passar em silencio
+            printf("%6d %7d %-9s %14s %14.6e %9s %9s  SEM BASELINE\n", config->N, config->T, config->metodo, "-",
+                   atual.mediana, "-", "-");
+            sem_base++;
+            continue;
+        }
+
+        estatisticas anterior;
+        compute_statistics(ref->amostras, ref->num_amostras, &anterior);
+        double variacao = atual.mediana / anterior.mediana - 1;
+        double p = mann_whitney_greater(ref->amostras, ref->num_amostras, config->amostras, config->num_amostras);
+        int regrediu = variacao > LIMIAR_REGRESSAO && p < SIGNIFICANCIA_REGRESSAO;
+        regressoes += regrediu;
+
+        printf("%6d %7d %-9s %14.6e %14.6e %+8.1f%% %9.4f  %s\n", config->N, config->T, config->metodo, anterior.mediana,
+               atual.mediana, 100 * variacao, p, regrediu ? "REGRESSAO" : "ok");
+    }
+
+    if (sem_base > 0)
+    {
+        printf("%d configuracao(oes) sem baseline em %s; grave com: teste regressao --gravar\n", sem_base, nome_arq);
+    }
+    if (regressoes > 0)
+    {
+        printf("%d configuracao(oes) com regressao de desempenho\n", regressoes);
+    }
+    return regressoes > 0 || sem_base > 0;
+}